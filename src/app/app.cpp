@@ -20,6 +20,9 @@
  */
 
 
+#include <iostream>
+#include <thread>
+
 #include "app.hpp"
 #include "utils.hpp"
 #include "mapping.hpp"
@@ -27,9 +30,17 @@
 #include "extractor.hpp"
 #include "document_writer.hpp"
 #include "compact.hpp"
+#include "force_refine.hpp"
+#include "radial_layout.hpp"
+#include "layout_session.hpp"
 #include "overlap_checks.hpp"
 #include "rted.hpp"
 #include "gted.hpp"
+#include "ted_cache.hpp"
+#include "prepared_template.hpp"
+#include "template_library.hpp"
+#include "distance_matrix.hpp"
+#include "shard.hpp"
 #include "overlap_checks.hpp"
 
 #define ARGS_HELP                           {"-h", "--help"}
@@ -43,18 +54,58 @@
 #define ARGS_DRAW_OVERLAPS                  "--overlaps"
 #define ARGS_VERBOSE                        {"-v", "--verbose"}
 #define ARGS_DEBUG                          {"--debug"}
+#define ARGS_CACHE_DIR                      "--cache-dir"
+#define ARGS_TEMPLATE_LIBRARY               "--template-library"
+#define ARGS_TEMPLATE_LIBRARY_TOP           "--top"
+#define ARGS_TEMPLATE_LIBRARY_INDEX         "--index"
+#define ARGS_DISTANCE_MATRIX                "--distance-matrix"
+#define ARGS_DISTANCE_MATRIX_THREADS        "--threads"
+#define ARGS_DISTANCE_MATRIX_MAPPINGS       "--mappings"
+#define ARGS_TARGET_LIST                    "--target-list"
+#define ARGS_TARGET_LIST_OVERLAPS           "--overlaps"
+#define ARGS_SHARD                          "--shard"
+#define ARGS_MERGE_SHARDS                   "--merge-shards"
+#define ARGS_REFINE                         "--refine"
+#define ARGS_REFINE_ITERATIONS              "--iterations"
+#define ARGS_LAYOUT_ENGINE                  "--layout-engine"
+#define ARGS_TED_BUDGET                     "--ted-budget"
+#define ARGS_SESSION                        "--session"
+#define ARGS_SESSION_OVERLAPS               "--overlaps"
 
 #define COLORED_FILENAME_EXTENSION          ".colored"
+#define TED_CACHE_ENGINE                    "rted+gted"
+#define TEMPLATE_LIBRARY_DEFAULT_TOP        3
+#define MAPPING_FILENAME_EXTENSION          ".map"
+#define LAYOUT_MANIFEST_FILENAME            "manifest.tsv"
+#define LAYOUT_MANIFEST_TYPE                "layout-manifest"
+#define REFINE_DEFAULT_ITERATIONS           100
+#define LAYOUT_ENGINE_TEMPLATE              "template"
+#define LAYOUT_ENGINE_RADIAL                "radial"
 
 
 
 using namespace std;
 
+/**
+ * loads vp_tree index of `library` from `index_file`, index is created if needed
+ */
+static vp_tree load_template_index(
+                                   const template_library& library,
+                                   const std::string& index_file);
+
+/**
+ * saves layout manifest `records` (target index, target, template, distance)
+ * as tab-separated values
+ */
+static void save_layout_manifest(
+                                 const std::string& filename,
+                                 const std::vector<std::vector<std::string>>& records);
+
 
 struct app::arguments
 {
-    rna_tree templated;
-    rna_tree matched;
+    rna_tree_ptr templated;
+    rna_tree_ptr matched;
     
     struct
     {
@@ -78,6 +129,53 @@ struct app::arguments
     {
         bool run = false;
     } traveler;
+    struct
+    {
+        string directory;
+    } cache;
+    struct
+    {
+        // 0 == refinement is not run
+        size_t iterations = 0;
+    } refine;
+    struct
+    {
+        string engine = LAYOUT_ENGINE_TEMPLATE;
+        // maximal product of tree sizes for TED, 0 == unlimited
+        size_t ted_budget = 0;
+    } layout;
+    struct
+    {
+        bool run = false;
+        bool overlap_checks = false;
+        string file;
+    } session;
+    struct
+    {
+        string directory;
+        size_t top = TEMPLATE_LIBRARY_DEFAULT_TOP;
+        string index;
+    } library;
+    struct
+    {
+        bool run = false;
+        size_t threads = max(1u, thread::hardware_concurrency());
+        string list;
+        string file;
+        string mappings;
+    } matrix;
+    struct
+    {
+        string list;
+        string directory;
+        bool overlap_checks = false;
+    } targets;
+    struct
+    {
+        size_t count = 0;
+        string file;
+    } merge;
+    shard part;
     
 public:
     /**
@@ -102,7 +200,7 @@ void app::run(
 
 
 void app::run(
-              arguments args)
+              const arguments& args)
 {
     
     
@@ -111,31 +209,89 @@ void app::run(
     INFO("BEG: APP");
     
     print(args);
+    
+    if (args.merge.count != 0)
+    {
+        run_merge_shards(args.merge.file, args.merge.count);
+        INFO("END: APP");
+        return;
+    }
+    if (args.matrix.run)
+    {
+        run_distance_matrix(args.matrix.list, args.matrix.file,
+                            args.matrix.threads, args.matrix.mappings, args.part);
+        INFO("END: APP");
+        return;
+    }
+    if (!args.targets.list.empty())
+    {
+        run_template_library_batch(args.library.directory, args.library.top, args.library.index,
+                                   args.targets.list, args.targets.directory,
+                                   args.targets.overlap_checks, args.refine.iterations, args.part);
+        INFO("END: APP");
+        return;
+    }
+    
+    if (args.session.run)
+    {
+        run_session(args.templated, args.matched, args.session.overlap_checks, args.session.file);
+        INFO("END: APP");
+        return;
+    }
+    
     bool rted = args.all.run || args.ted.run || args.traveler.run;
     bool draw = args.all.run || args.draw.run;
     bool overlaps = args.all.overlap_checks || args.draw.overlap_checks;
     mapping map;
-    string img_out = args.all.file;
+    string img_out = args.draw.run ? args.draw.file : args.all.file;
+    rna_tree_ptr templated = args.templated;
+    bool radial = args.layout.engine == LAYOUT_ENGINE_RADIAL;
     
-    map = run_ted(args.templated, args.matched, rted, args.ted.mapping);
+    if (!radial && rted && args.library.directory.empty() &&
+        args.layout.ted_budget != 0 && templated != nullptr &&
+        templated->size() * args.matched->size() > args.layout.ted_budget)
+    {
+        // mapping file would not be written
+        if (args.ted.run)
+            throw aplication_error("TED of %s x %s nodes exceeds budget %s, mapping %s cannot be computed",
+                                   templated->size(), args.matched->size(), args.layout.ted_budget,
+                                   args.ted.mapping).with(ERROR_TED);
+        
+        WARN("TED of %s x %s nodes exceeds budget %s, radial layout is used",
+             templated->size(), args.matched->size(), args.layout.ted_budget);
+        radial = true;
+    }
+    if (radial)
+    {
+        if (draw)
+            run_radial(templated, args.matched, overlaps, img_out);
+        INFO("END: APP");
+        return;
+    }
+    
+    if (!args.library.directory.empty())
+        map = run_template_library(templated, args.matched, args.library.directory,
+                                   args.library.top, args.library.index, args.ted.mapping);
+    else
+        map = run_ted(templated, args.matched, rted, args.ted.mapping, args.cache.directory);
     
     if (args.draw.run)
     {
         assert(!args.draw.mapping.empty());
         map = load_mapping_table(args.draw.mapping);
-        img_out = args.draw.file;
     }
     
-    run_drawing(args.templated, args.matched, map, draw, overlaps, img_out);
+    run_drawing(templated, args.matched, map, draw, overlaps, args.refine.iterations, img_out);
     
     INFO("END: APP");
 }
 
 mapping app::run_ted(
-                     rna_tree& templated,
-                     rna_tree& matched,
+                     const rna_tree_ptr& templated,
+                     const rna_tree_ptr& matched,
                      bool run,
-                     const std::string& mapping_file)
+                     const std::string& mapping_file,
+                     const std::string& cache_dir)
 {
     APP_DEBUG_FNAME;
     
@@ -145,15 +301,12 @@ mapping app::run_ted(
         
         if (run)
         {
+            prepared_template templ(templated);
             
-           
-            rted r(templated, matched); //Gets a strategy for decomposing a tree
-            r.run();
-            
-            gted g(templated, matched); //Computes mapping and ditstanve based on RTED's strategy (faster than using GTED itself)
-            g.run(r.get_strategies());
-    
-            mapping = g.get_mapping();
+            if (cache_dir.empty())
+                mapping = templ.run_ted(matched);
+            else
+                mapping = run_ted_cached(templ, matched, cache_dir);
             
             if (!mapping_file.empty())
                 save_tree_mapping_table(mapping_file, mapping);
@@ -172,12 +325,262 @@ mapping app::run_ted(
     
 }
 
+mapping app::run_ted_cached(
+                            const prepared_template& templ,
+                            const rna_tree_ptr& matched,
+                            const std::string& cache_dir)
+{
+    APP_DEBUG_FNAME;
+    
+    ted_cache cache(cache_dir);
+    string key = ted_cache::get_key(templ.get_rna(), *matched, TED_CACHE_ENGINE);
+    mapping mapping;
+    
+    if (cache.load_mapping(key, mapping))
+        return mapping;
+    
+    strategy_table_type strategies;
+    if (!cache.load_strategies(key, strategies))
+    {
+        rted r = templ.get_rted(matched); //Gets a strategy for decomposing a tree
+        r.run();
+        strategies = r.get_strategies();
+        cache.save_strategies(key, strategies);
+    }
+    
+    gted g = templ.get_gted(*matched); //Computes mapping and ditstanve based on RTED's strategy (faster than using GTED itself)
+    g.run(strategies);
+    mapping = g.get_mapping();
+    cache.save_mapping(key, mapping);
+    
+    return mapping;
+}
+
+mapping app::run_template_library(
+                                  rna_tree_ptr& templated,
+                                  const rna_tree_ptr& matched,
+                                  const std::string& directory,
+                                  size_t top,
+                                  const std::string& index_file,
+                                  const std::string& mapping_file)
+{
+    APP_DEBUG_FNAME;
+    
+    try
+    {
+        template_library library(directory);
+        vp_tree index = load_template_index(library, index_file);
+        template_library::result res = index_file.empty() ?
+        library.find_best(matched, top) :
+        library.find_best(matched, index);
+        const template_library::entry& best = library.get_entries().at(res.index);
+        
+        {
+            LOGGER_PRIORITY_ON_FUNCTION(INFO);
+            
+            INFO("Template library: %s templates, %s pruned by size/histograms, "
+                 "%s pruned by euler strings, %s pruned by index, %s skipped by --top, %s TED runs",
+                 library.get_entries().size(), res.pruned_by_histograms,
+                 res.pruned_by_euler, res.pruned_by_index, res.skipped_by_top, res.ted_runs);
+            INFO("Best template: %s (%s), distance %s",
+                 best.name, best.image_file, res.map.distance);
+        }
+        
+        templated = library.create_templated(res.index);
+        
+        if (!mapping_file.empty())
+            save_tree_mapping_table(mapping_file, res.map);
+        
+        return res.map;
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Template library search failed: %s", e).with(ERROR_TED);
+    }
+}
+
+void app::run_distance_matrix(
+                              const std::string& list_file,
+                              const std::string& file,
+                              size_t threads,
+                              const std::string& mapping_dir,
+                              const shard& part)
+{
+    APP_DEBUG_FNAME;
+    
+    try
+    {
+        vector<rna_tree_ptr> rnas;
+        vector<string> names;
+        
+        // structures are loaded once
+        for (const string& fastafile : read_list(list_file, names))
+            rnas.push_back(create_matched(fastafile));
+        
+        if (!mapping_dir.empty())
+            create_directory(mapping_dir);
+        
+        auto save_mapping = [&names, &mapping_dir](size_t i, size_t j, const mapping& map)
+        {
+            save_tree_mapping_table(mapping_dir + "/" + names[i] + "-" + names[j] + MAPPING_FILENAME_EXTENSION, map);
+        };
+        
+        distance_matrix matrix(rnas, names);
+        if (mapping_dir.empty())
+            matrix.run(threads, nullptr, part);
+        else
+            matrix.run(threads, save_mapping, part);
+        
+        if (part.is_whole())
+        {
+            matrix.save(file);
+            INFO("Distance matrix of %s structures saved to %s", rnas.size(), file);
+        }
+        else
+        {
+            matrix.save_partial(file);
+            INFO("Shard %s/%s of distance matrix saved to %s", part.index, part.count, part.get_filename(file));
+        }
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Distance matrix computation failed: %s", e).with(ERROR_TED);
+    }
+}
+
+void app::run_template_library_batch(
+                                     const std::string& directory,
+                                     size_t top,
+                                     const std::string& index_file,
+                                     const std::string& list_file,
+                                     const std::string& out_dir,
+                                     bool overlaps,
+                                     size_t refine_iterations,
+                                     const shard& part)
+{
+    APP_DEBUG_FNAME;
+    
+    try
+    {
+        template_library library(directory);
+        vp_tree index = load_template_index(library, index_file);
+        vector<string> names;
+        vector<string> files = read_list(list_file, names);
+        shard_output manifest;
+        
+        manifest.type = LAYOUT_MANIFEST_TYPE;
+        manifest.part = part;
+        manifest.names = names;
+        
+        create_directory(out_dir);
+        
+        for (size_t k = 0; k < files.size(); ++k)
+        {
+            if (!part.contains(k))
+                continue;
+            
+            rna_tree_ptr matched = create_matched(files[k]);
+            string prefix = out_dir + "/" + names[k];
+            template_library::result res = index_file.empty() ?
+            library.find_best(matched, top) :
+            library.find_best(matched, index);
+            rna_tree_ptr templated = library.create_templated(res.index);
+            
+            save_tree_mapping_table(prefix + MAPPING_FILENAME_EXTENSION, res.map);
+            run_drawing(templated, matched, res.map, true, overlaps, refine_iterations, prefix);
+            
+            manifest.records.push_back({
+                to_string(k),
+                names[k],
+                library.get_entries().at(res.index).name,
+                to_string(res.map.distance)});
+        }
+        
+        string manifest_file = out_dir + "/" + LAYOUT_MANIFEST_FILENAME;
+        
+        if (part.is_whole())
+            save_layout_manifest(manifest_file, manifest.records);
+        else
+            manifest.save(part.get_filename(manifest_file));
+        
+        INFO("Layouts of %s targets drawn to %s", manifest.records.size(), out_dir);
+    }
+    catch (const aplication_error&)
+    {
+        throw;
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Template library search failed: %s", e).with(ERROR_TED);
+    }
+}
+
+void app::run_merge_shards(
+                           const std::string& file,
+                           size_t count)
+{
+    APP_DEBUG_FNAME;
+    
+    try
+    {
+        vector<shard_output> outputs = shard_output::load_all(file, count);
+        
+        if (outputs[0].type == LAYOUT_MANIFEST_TYPE)
+        {
+            const size_t n = outputs[0].names.size();
+            vector<vector<string>> records(n);
+            
+            for (const shard_output& output : outputs)
+                for (const auto& record : output.records)
+                {
+                    size_t k;
+                
+                    try
+                    {
+                        if (record.size() != 4)
+                            throw invalid_argument("record size");
+                    
+                        k = shard_output::parse_number(record[0]);
+                    }
+                    catch (const logic_error&)
+                    {
+                        throw io_exception("Shard output %s contains wrong record", output.part.get_filename(file));
+                    }
+                
+                    if (k >= n)
+                        throw io_exception("Shard output %s contains wrong record", output.part.get_filename(file));
+                    if (!records[k].empty())
+                        throw io_exception("Target %s is drawn by more shards", record[1]);
+                
+                    records[k] = record;
+                }
+            
+            for (size_t k = 0; k < n; ++k)
+                if (records[k].empty())
+                    throw io_exception("Target %s is missing in shard outputs of %s", outputs[0].names[k], file);
+            
+            save_layout_manifest(file, records);
+        }
+        else
+        {
+            distance_matrix::merge(file, count).save(file);
+        }
+        
+        INFO("Shard outputs of %s merged", file);
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Merging shard outputs failed: %s", e).with(ERROR_ARGUMENTS);
+    }
+}
+
 void app::run_drawing(
-                      rna_tree& templated,
-                      rna_tree& matched,
+                      const rna_tree_ptr& templated,
+                      const rna_tree_ptr& matched,
                       const mapping& mapping,
                       bool run,
                       bool run_overlaps,
+                      size_t refine_iterations,
                       const std::string& file)
 {
     APP_DEBUG_FNAME;
@@ -191,12 +594,88 @@ void app::run_drawing(
         }
         
         //Based on a mapping, matcher returns structure with deleted and inserted nodes
-        // which correspond to the target structure
-        templated = matcher(templated, matched).run(mapping);
+        // which correspond to the target structure; it is matcher's own copy of templated
+        matcher match(*templated, *matched);
+        rna_tree& rna = match.run(mapping);
         //Compact goes through the structure and computes new coordinates where necessary
-        compact(templated).run();
+        //only loops edited by matcher are laid out again
+        compact(rna, match.get_edited(), max(1u, thread::hardware_concurrency())).run();
+        //Optionally, inserted parts are relaxed by force-directed refinement
+        if (refine_iterations != 0)
+            force_refine(rna, refine_iterations).run();
         
-        save(file, templated, run_overlaps);
+        save(file, rna, run_overlaps);
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Drawing structure failed: %s", e).with(ERROR_DRAW);
+    }
+}
+
+void app::run_radial(
+                     const rna_tree_ptr& templated,
+                     const rna_tree_ptr& matched,
+                     bool run_overlaps,
+                     const std::string& file)
+{
+    APP_DEBUG_FNAME;
+    
+    try
+    {
+        rna_tree rna = *matched;
+        
+        if (templated != nullptr)
+            radial_layout(rna, *templated).run();
+        else
+            radial_layout(rna).run();
+        
+        save(file, rna, run_overlaps);
+    }
+    catch (const my_exception& e)
+    {
+        throw aplication_error("Drawing structure failed: %s", e).with(ERROR_DRAW);
+    }
+}
+
+void app::run_session(
+                      const rna_tree_ptr& templated,
+                      const rna_tree_ptr& matched,
+                      bool run_overlaps,
+                      const std::string& file)
+{
+    APP_DEBUG_FNAME;
+    
+    try
+    {
+        layout_session session(templated, max(1u, thread::hardware_concurrency()));
+        rna_tree rna = session.layout(matched);
+        string line;
+        
+        save(file, rna, run_overlaps);
+        cout << file << endl;
+        
+        // every line is next version of target: LABELS BRACKETS, empty line ends session;
+        // layout is saved to `file` again and its name is printed when it is done
+        while (getline(cin, line) && !line.empty())
+        {
+            istringstream in(line);
+            string labels, brackets;
+            
+            try
+            {
+                if (!(in >> labels >> brackets))
+                    throw wrong_argument_exception("Session line '%s' is not in format LABELS BRACKETS", line);
+                
+                rna = session.update(brackets, labels);
+                save(file, rna, run_overlaps);
+                cout << file << endl;
+            }
+            catch (const wrong_argument_exception& e)
+            {
+                ERR("Target was not updated: %s", e);
+                cout << "error: " << e.what() << endl;
+            }
+        }
     }
     catch (const my_exception& e)
     {
@@ -223,8 +702,13 @@ void app::save(
             writer->init(file, rna.begin());
             writer->print(writer->get_rna_formatted(rna));
             
+            // traveler_writer does not draw circles, document has to be printed only once
             for (const auto& p : overlaps)
-                writer->print(writer->get_circle_formatted(p.centre, p.radius));
+            {
+                string circle = writer->get_circle_formatted(p.centre, p.radius);
+                if (!circle.empty())
+                    writer->print(circle);
+            }
         }
     }
     
@@ -241,7 +725,7 @@ void app::save(
 
 
 
-rna_tree app::create_matched(
+rna_tree_ptr app::create_matched(
                              const std::string& fastafile)
 {
     APP_DEBUG_FNAME;
@@ -249,7 +733,7 @@ rna_tree app::create_matched(
     try
     {
         fasta f = read_fasta_file(fastafile);
-        return rna_tree(f.brackets, f.labels, f.id);
+        return make_shared<rna_tree>(f.brackets, f.labels, f.id);
     }
     catch (const my_exception& e)
     {
@@ -257,7 +741,7 @@ rna_tree app::create_matched(
     }
 }
 
-rna_tree app::create_templated(
+rna_tree_ptr app::create_templated(
                                const std::string& templatefile,
                                const std::string& templatetype,
                                const std::string& fastafile)
@@ -268,7 +752,7 @@ rna_tree app::create_templated(
     {
         extractor_ptr doc = extractor::get_extractor(templatefile, templatetype);
         fasta f = read_fasta_file(fastafile);
-        return rna_tree(f.brackets, doc->labels, doc->points, f.id);
+        return make_shared<rna_tree>(f.brackets, doc->labels, doc->points, f.id);
     }
     catch (const my_exception& e)
     {
@@ -276,6 +760,34 @@ rna_tree app::create_templated(
     }
 }
 
+std::vector<std::string> app::read_list(
+                                        const std::string& list_file,
+                                        std::vector<std::string>& names)
+{
+    APP_DEBUG_FNAME;
+    
+    vector<string> files;
+    string list_dir = list_file.substr(0, list_file.find_last_of('/') + 1);
+    istringstream list(read_file(list_file));
+    string line;
+    
+    names.clear();
+    while (getline(list, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        
+        string fastafile = (line[0] == '/') ? line : list_dir + line;
+        string name = fastafile.substr(fastafile.find_last_of('/') + 1);
+        name = name.substr(0, name.find_last_of('.'));
+        
+        files.push_back(fastafile);
+        names.push_back(name);
+    }
+    
+    return files;
+}
+
 
 
 
@@ -324,6 +836,50 @@ void app::usage(
     << "] [" << ARGS_DRAW_OVERLAPS << "] FILE_MAPPING_IN FILE_OUT"
     << endl
     << "\t[" << get_args(ARGS_VERBOSE) << "]"
+    << endl
+    << "\t[" << ARGS_CACHE_DIR << " CACHE_DIR]"
+    << endl
+    << "\t[" << ARGS_REFINE
+    << " [" << ARGS_REFINE_ITERATIONS << " N]]"
+    << endl
+    << "\t[" << ARGS_LAYOUT_ENGINE
+    << " " << LAYOUT_ENGINE_TEMPLATE << "|" << LAYOUT_ENGINE_RADIAL << "]"
+    << endl
+    << "\t[" << ARGS_TED_BUDGET << " N]"
+    << endl
+    << "\t[" << ARGS_SESSION
+    << " [" << ARGS_SESSION_OVERLAPS << "] FILE_OUT]"
+    << endl
+    << endl
+    << appname
+    << " [OPTIONS]"
+    << " <" << get_args(ARGS_TARGET_STRUCTURE) << ">"
+    << " DBN_FILE"
+    << " " << ARGS_TEMPLATE_LIBRARY
+    << " [" << ARGS_TEMPLATE_LIBRARY_TOP << " K]"
+    << " [" << ARGS_TEMPLATE_LIBRARY_INDEX << " INDEX_FILE]"
+    << " LIBRARY_DIR"
+    << endl
+    << appname
+    << " " << ARGS_TEMPLATE_LIBRARY
+    << " [" << ARGS_TEMPLATE_LIBRARY_TOP << " K]"
+    << " [" << ARGS_TEMPLATE_LIBRARY_INDEX << " INDEX_FILE]"
+    << " LIBRARY_DIR"
+    << " " << ARGS_TARGET_LIST
+    << " [" << ARGS_TARGET_LIST_OVERLAPS << "]"
+    << " LIST_FILE OUT_DIR"
+    << " [" << ARGS_SHARD << " i/N]"
+    << endl
+    << appname
+    << " " << ARGS_DISTANCE_MATRIX
+    << " [" << ARGS_DISTANCE_MATRIX_THREADS << " N]"
+    << " [" << ARGS_DISTANCE_MATRIX_MAPPINGS << " MAPPING_DIR]"
+    << " LIST_FILE FILE_OUT"
+    << " [" << ARGS_SHARD << " i/N]"
+    << endl
+    << appname
+    << " " << ARGS_MERGE_SHARDS
+    << " N FILE_OUT"
     << endl;
 }
 
@@ -332,9 +888,16 @@ void app::print(
 {
     APP_DEBUG_FNAME;
     
+    auto print_rna = [](const rna_tree_ptr& rna)
+    {
+        if (rna == nullptr)
+            return string("-");
+        return rna->name() + ": " + rna->print_tree(false);
+    };
+    
     INFO("ARGUMENTS:\n"
-         "templated: %s: %s\n"
-         "matched: %s: %s\n"
+         "templated: %s\n"
+         "matched: %s\n"
          "all:\n"
          "\trun=%s\n"
          "\timage-file=%s\n"
@@ -346,12 +909,49 @@ void app::print(
          "\trun=%s\n"
          "\toverlaps=%s\n"
          "\tmapping-file=%s\n"
-         "\timage-file=%s",
-         args.templated.name(), args.templated.print_tree(false),
-         args.matched.name(), args.matched.print_tree(false),
+         "\timage-file=%s\n"
+         "cache:\n"
+         "\tdirectory=%s\n"
+         "refine:\n"
+         "\titerations=%s\n"
+         "layout:\n"
+         "\tengine=%s\n"
+         "\tted-budget=%s\n"
+         "session:\n"
+         "\trun=%s\n"
+         "\toverlaps=%s\n"
+         "\timage-file=%s\n"
+         "template-library:\n"
+         "\tdirectory=%s\n"
+         "\ttop=%s\n"
+         "\tindex=%s\n"
+         "distance-matrix:\n"
+         "\trun=%s\n"
+         "\tthreads=%s\n"
+         "\tlist-file=%s\n"
+         "\tmatrix-file=%s\n"
+         "\tmappings=%s\n"
+         "target-list:\n"
+         "\tlist-file=%s\n"
+         "\tdirectory=%s\n"
+         "\toverlaps=%s\n"
+         "shard: %s/%s\n"
+         "merge-shards:\n"
+         "\tcount=%s\n"
+         "\tfile=%s",
+         print_rna(args.templated), print_rna(args.matched),
          args.all.run, args.all.file, args.all.overlap_checks,
          args.ted.run, args.ted.mapping,
-         args.draw.run, args.draw.overlap_checks, args.draw.mapping, args.draw.file);
+         args.draw.run, args.draw.overlap_checks, args.draw.mapping, args.draw.file,
+         args.cache.directory,
+         args.refine.iterations,
+         args.layout.engine, args.layout.ted_budget,
+         args.session.run, args.session.overlap_checks, args.session.file,
+         args.library.directory, args.library.top, args.library.index,
+         args.matrix.run, args.matrix.threads, args.matrix.list, args.matrix.file, args.matrix.mappings,
+         args.targets.list, args.targets.directory, args.targets.overlap_checks,
+         args.part.index, args.part.count,
+         args.merge.count, args.merge.file);
     
     
 }
@@ -474,6 +1074,133 @@ void app::print(
                 a.draw.file = args.at(i + 2);
                 i += 2;
             }
+            else if (arg == ARGS_CACHE_DIR)
+            {
+                DEBUG("arg cache-dir");
+                a.cache.directory = args.at(i + 1);
+                i += 1;
+            }
+            else if (arg == ARGS_TEMPLATE_LIBRARY)
+            {
+                DEBUG("arg template-library");
+                while (true)
+                {
+                    if (nextarg() == ARGS_TEMPLATE_LIBRARY_TOP)
+                    {
+                        a.library.top = stoul(args.at(i + 2));
+                        if (a.library.top == 0)
+                            throw wrong_argument_exception("%s has to be positive", ARGS_TEMPLATE_LIBRARY_TOP);
+                        i += 2;
+                    }
+                    else if (nextarg() == ARGS_TEMPLATE_LIBRARY_INDEX)
+                    {
+                        a.library.index = args.at(i + 2);
+                        i += 2;
+                    }
+                    else
+                        break;
+                }
+                a.library.directory = args.at(i + 1);
+                i += 1;
+            }
+            else if (arg == ARGS_DISTANCE_MATRIX)
+            {
+                DEBUG("arg distance-matrix");
+                a.matrix.run = true;
+                while (true)
+                {
+                    if (nextarg() == ARGS_DISTANCE_MATRIX_THREADS)
+                    {
+                        a.matrix.threads = stoul(args.at(i + 2));
+                        if (a.matrix.threads == 0)
+                            throw wrong_argument_exception("%s has to be positive", ARGS_DISTANCE_MATRIX_THREADS);
+                        i += 2;
+                    }
+                    else if (nextarg() == ARGS_DISTANCE_MATRIX_MAPPINGS)
+                    {
+                        a.matrix.mappings = args.at(i + 2);
+                        i += 2;
+                    }
+                    else
+                        break;
+                }
+                a.matrix.list = args.at(i + 1);
+                a.matrix.file = args.at(i + 2);
+                i += 2;
+            }
+            else if (arg == ARGS_TARGET_LIST)
+            {
+                DEBUG("arg target-list");
+                while (true)
+                {
+                    if (nextarg() == ARGS_TARGET_LIST_OVERLAPS)
+                    {
+                        a.targets.overlap_checks = true;
+                        i += 1;
+                    }
+                    else
+                        break;
+                }
+                a.targets.list = args.at(i + 1);
+                a.targets.directory = args.at(i + 2);
+                i += 2;
+            }
+            else if (arg == ARGS_REFINE)
+            {
+                DEBUG("arg refine");
+                a.refine.iterations = REFINE_DEFAULT_ITERATIONS;
+                if (nextarg() == ARGS_REFINE_ITERATIONS)
+                {
+                    a.refine.iterations = stoul(args.at(i + 2));
+                    if (a.refine.iterations == 0)
+                        throw wrong_argument_exception("%s has to be positive", ARGS_REFINE_ITERATIONS);
+                    i += 2;
+                }
+            }
+            else if (arg == ARGS_LAYOUT_ENGINE)
+            {
+                DEBUG("arg layout-engine");
+                a.layout.engine = args.at(i + 1);
+                if (a.layout.engine != LAYOUT_ENGINE_TEMPLATE &&
+                    a.layout.engine != LAYOUT_ENGINE_RADIAL)
+                    throw wrong_argument_exception("Unknown layout engine %s", a.layout.engine);
+                i += 1;
+            }
+            else if (arg == ARGS_TED_BUDGET)
+            {
+                DEBUG("arg ted-budget");
+                a.layout.ted_budget = stoul(args.at(i + 1));
+                if (a.layout.ted_budget == 0)
+                    throw wrong_argument_exception("%s has to be positive", ARGS_TED_BUDGET);
+                i += 1;
+            }
+            else if (arg == ARGS_SESSION)
+            {
+                DEBUG("arg session");
+                a.session.run = true;
+                if (nextarg() == ARGS_SESSION_OVERLAPS)
+                {
+                    a.session.overlap_checks = true;
+                    i += 1;
+                }
+                a.session.file = args.at(i + 1);
+                i += 1;
+            }
+            else if (arg == ARGS_SHARD)
+            {
+                DEBUG("arg shard");
+                a.part = shard::parse(args.at(i + 1));
+                i += 1;
+            }
+            else if (arg == ARGS_MERGE_SHARDS)
+            {
+                DEBUG("arg merge-shards");
+                a.merge.count = stoul(args.at(i + 1));
+                if (a.merge.count == 0)
+                    throw wrong_argument_exception("%s has to be positive", ARGS_MERGE_SHARDS);
+                a.merge.file = args.at(i + 2);
+                i += 2;
+            }
             else if (is_argument(ARGS_VERBOSE))
             {
                 logger.set_priority(logger::INFO);
@@ -491,7 +1218,29 @@ void app::print(
             }
         }
         
-        if (a.templated == rna_tree() || a.matched == rna_tree())
+        if (a.merge.count != 0)
+            return a;
+        if (!a.part.is_whole() && !a.matrix.run && a.targets.list.empty())
+            throw wrong_argument_exception("%s can be used only with %s or %s", ARGS_SHARD, ARGS_DISTANCE_MATRIX, ARGS_TARGET_LIST);
+        if (a.matrix.run)
+            return a;
+        if (!a.targets.list.empty())
+        {
+            if (a.library.directory.empty())
+                throw wrong_argument_exception("%s can be used only with %s", ARGS_TARGET_LIST, ARGS_TEMPLATE_LIBRARY);
+            return a;
+        }
+        
+        if (!a.library.directory.empty() && a.templated != nullptr)
+            throw wrong_argument_exception("Template structure and template library cannot be used together");
+        if (a.session.run && a.templated == nullptr)
+            throw wrong_argument_exception("%s can be used only with template structure", ARGS_SESSION);
+        if (a.ted.run && a.layout.engine == LAYOUT_ENGINE_RADIAL)
+            throw wrong_argument_exception("--ted cannot be used with %s %s, radial layout computes no mapping",
+                                           ARGS_LAYOUT_ENGINE, LAYOUT_ENGINE_RADIAL);
+        if (a.library.directory.empty() && a.templated == nullptr)
+            throw wrong_argument_exception("RNA structures are missing, try running %s --help for more arguments details", args[0]);
+        if (a.matched == nullptr)
             throw wrong_argument_exception("RNA structures are missing, try running %s --help for more arguments details", args[0]);
         
         return a;
@@ -501,3 +1250,53 @@ void app::print(
         throw aplication_error("Error while parsing arguments: %s", e).with(ERROR_ARGUMENTS);
     }
 }
+
+
+/* local */ vp_tree load_template_index(
+                                        const template_library& library,
+                                        const std::string& index_file)
+{
+    APP_DEBUG_FNAME;
+    
+    vp_tree index;
+    
+    if (index_file.empty())
+        return index;
+    
+    if (exist_file(index_file))
+    {
+        try
+        {
+            index = vp_tree::load(index_file);
+        }
+        catch (const io_exception& e)
+        {
+            // index of older version or broken file is created again
+            WARN("%s", e);
+        }
+    }
+    if (!library.is_valid_index(index))
+    {
+        if (exist_file(index_file))
+            WARN("Index %s does not match template library, creating new one", index_file);
+        index = library.create_index();
+        index.save(index_file);
+    }
+    
+    return index;
+}
+
+/* local */ void save_layout_manifest(
+                                      const std::string& filename,
+                                      const std::vector<std::vector<std::string>>& records)
+{
+    APP_DEBUG_FNAME;
+    
+    ostringstream out;
+    
+    out << "target\ttemplate\tdistance" << endl;
+    for (const auto& record : records)
+        out << record[1] << "\t" << record[2] << "\t" << record[3] << endl;
+    
+    write_file(filename, out.str());
+}
@@ -0,0 +1,397 @@
+/*
+ * File: layout_session.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#include <chrono>
+
+#include "layout_session.hpp"
+#include "dot_bracket.hpp"
+#include "tree_matcher.hpp"
+#include "compact.hpp"
+
+using namespace std;
+
+typedef rna_tree::pre_post_order_iterator pre_post_order_iterator;
+
+/**
+ * returns numbers of nodes closed before each base, nodes are closed
+ * by unpaired bases and closing brackets (in postorder);
+ * 1-based postorder id of node closed at `i` is closed[i + 1]
+ */
+/* local */ vector<size_t> get_closed_counts(
+                                             const dot_bracket& db)
+{
+    vector<size_t> closed(db.size() + 1, 0);
+    
+    for (size_t i = 0; i < db.size(); ++i)
+        closed[i + 1] = closed[i] + (db.is_opening(i) ? 0 : 1);
+    
+    return closed;
+}
+
+/**
+ * returns mass centre of initiated bases in subtree of `root`
+ */
+/* local */ point get_subtree_centre(
+                                     rna_tree::iterator root)
+{
+    point sum(0, 0);
+    size_t n = 0;
+    
+    auto f = [&](const pre_post_order_iterator& it)
+    {
+        const point& p = it->at(it.label_index()).p;
+        
+        if (!p.bad())
+        {
+            sum += p;
+            ++n;
+        }
+    };
+    rna_tree::for_each_in_subtree(root, f);
+    
+    return n == 0 ? point::bad_point() : point(sum.x / n, sum.y / n);
+}
+
+/**
+ * returns on which side of line p1 -> p2 lies `p`, 0 for line or bad points
+ */
+/* local */ int get_side(
+                         const point& p1,
+                         const point& p2,
+                         const point& p)
+{
+    if (p1.bad() || p2.bad() || p.bad())
+        return 0;
+    
+    double cross = (p2.x - p1.x) * (p.y - p1.y) - (p2.y - p1.y) * (p.x - p1.x);
+    
+    return iszero(cross) ? 0 : (cross > 0 ? 1 : -1);
+}
+
+
+layout_session::layout_session(
+                               const rna_tree_ptr& templated,
+                               size_t _threads)
+: templ(templated), threads(_threads)
+{
+    templ_rna = templ.get_rna();
+    
+    templ_nodes.resize(templ_rna.size());
+    for (iterator it = templ_rna.begin(); it != templ_rna.end(); ++it)
+        templ_nodes.at(id(it)) = it;
+}
+
+const rna_tree& layout_session::layout(
+                                       const rna_tree_ptr& matched)
+{
+    APP_DEBUG_FNAME;
+    
+    assert(matched != nullptr);
+    
+    INFO("BEG: Session layout of %s", matched->name());
+    
+    name = matched->name();
+    brackets = matched->get_brackets();
+    labels = matched->get_labels();
+    map = templ.run_ted(matched);
+    draw(*matched, map, nullptr);
+    
+    INFO("END: Session layout of %s", name);
+    
+    return rna;
+}
+
+const rna_tree& layout_session::update(
+                                       const delta& d)
+{
+    APP_DEBUG_FNAME;
+    
+    if (d.begin > d.end || d.end > labels.size())
+        throw wrong_argument_exception("Changed bases [%s, %s) are out of target of length %s",
+                                       d.begin, d.end, labels.size());
+    if (d.brackets.size() != d.labels.size())
+        throw wrong_argument_exception("Change has %s brackets but %s labels",
+                                       d.brackets.size(), d.labels.size());
+    
+    auto start = chrono::steady_clock::now();
+    
+    string new_brackets = brackets;
+    string new_labels = labels;
+    new_brackets.replace(d.begin, d.end - d.begin, d.brackets);
+    new_labels.replace(d.begin, d.end - d.begin, d.labels);
+    
+    // nothing changes (empty delta or the same bases), layout and mapping stay
+    if (new_brackets == brackets && new_labels == labels)
+        return rna;
+    
+    INFO("BEG: Session update of %s, bases [%s, %s) -> %s",
+         name, d.begin, d.end, d.labels);
+    
+    rna_tree_ptr target = make_shared<rna_tree>(new_brackets, new_labels, name);
+    dot_bracket old_db = dot_bracket::parse(brackets);
+    dot_bracket new_db = dot_bracket::parse(new_brackets);
+    vector<size_t> old_closed = get_closed_counts(old_db);
+    vector<size_t> new_closed = get_closed_counts(new_db);
+    
+    // template ids of old target nodes, 0 == inserted
+    vector<size_t> templ_of(old_closed.back() + 2, 0);
+    for (const auto& m : map.map)
+        if (m.to != 0)
+            templ_of.at(m.to) = m.from;
+    
+    // smallest pair enclosing the change, which is matched
+    // to template pair and which is kept in new target
+    region r;
+    bool found = false;
+    
+    for (size_t i = d.begin; i-- > 0 && !found;)
+    {
+        if (!old_db.is_opening(i) || old_db.pairs[i] < d.end)
+            continue;
+        
+        size_t j = old_db.pairs[i];
+        size_t new_j = j - d.end + d.begin + d.brackets.size();
+        
+        if (new_db.pairs[i] != new_j)
+            continue;
+        
+        r.old_id = old_closed[j + 1];
+        r.old_size = old_closed[j + 1] - old_closed[i];
+        r.templ_id = templ_of.at(r.old_id);
+        
+        if (r.templ_id == 0 || !templ_nodes.at(r.templ_id - 1)->paired())
+            continue;
+        
+        r.begin = i;
+        r.end = new_j;
+        r.new_id = new_closed[new_j + 1];
+        r.new_size = new_closed[new_j + 1] - new_closed[i];
+        found = true;
+    }
+    
+    mapping m;
+    
+    if (found && rematch(new_brackets, new_labels, r, m))
+    {
+        draw(*target, m, &r);
+    }
+    else
+    {
+        INFO("No matched pair encloses the change, %s is laid out from scratch", name);
+        m = templ.run_ted(target);
+        draw(*target, m, nullptr);
+    }
+    
+    map = m;
+    brackets = target->get_brackets();
+    labels = target->get_labels();
+    
+    INFO("END: Session update of %s in %s ms", name,
+         chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count());
+    
+    return rna;
+}
+
+const rna_tree& layout_session::update(
+                                       const std::string& new_brackets,
+                                       const std::string& new_labels)
+{
+    return update(diff(brackets, labels, new_brackets, new_labels));
+}
+
+/* static */ layout_session::delta layout_session::diff(
+                                                        const std::string& brackets,
+                                                        const std::string& labels,
+                                                        const std::string& new_brackets,
+                                                        const std::string& new_labels)
+{
+    if (brackets.size() != labels.size() || new_brackets.size() != new_labels.size())
+        throw wrong_argument_exception("Brackets and labels of target have to be of the same length");
+    
+    size_t n = labels.size();
+    size_t new_n = new_labels.size();
+    size_t prefix = 0, suffix = 0;
+    
+    auto same = [&](size_t i, size_t new_i)
+    {
+        return brackets[i] == new_brackets[new_i] && labels[i] == new_labels[new_i];
+    };
+    
+    while (prefix < min(n, new_n) && same(prefix, prefix))
+        ++prefix;
+    while (suffix < min(n, new_n) - prefix && same(n - suffix - 1, new_n - suffix - 1))
+        ++suffix;
+    
+    return {prefix, n - suffix,
+        new_brackets.substr(prefix, new_n - suffix - prefix),
+        new_labels.substr(prefix, new_n - suffix - prefix)};
+}
+
+
+bool layout_session::rematch(
+                             const std::string& new_brackets,
+                             const std::string& new_labels,
+                             region& r,
+                             mapping& out) const
+{
+    APP_DEBUG_FNAME;
+    
+    iterator root = templ_nodes.at(r.templ_id - 1);
+    rna_tree sub_templated(rna_tree::get_brackets(root), rna_tree::get_labels(root));
+    rna_tree sub_matched(new_brackets.substr(r.begin, r.end - r.begin + 1),
+                         new_labels.substr(r.begin, r.end - r.begin + 1));
+    mapping sub = prepared_template(sub_templated).run_ted(sub_matched);
+    
+    // subtrees are nodes with ids in (first, id]
+    r.templ_size = sub_templated.size() - 1;
+    size_t templ_first = r.templ_id - r.templ_size;
+    size_t old_first = r.old_id - r.old_size;
+    size_t new_first = r.new_id - r.new_size;
+    
+    auto inside = [](size_t id, size_t first, size_t last)
+    {
+        return id > first && id <= last;
+    };
+    
+    // distance is number of inserted and deleted nodes, see gted::get_mapping()
+    out.map.clear();
+    out.distance = map.distance + sub.distance;
+    
+    for (mapping::mapping_pair m : map.map)
+    {
+        bool from_inside = inside(m.from, templ_first, r.templ_id);
+        bool to_inside = inside(m.to, old_first, r.old_id);
+        
+        if (from_inside || to_inside)
+        {
+            if ((m.from != 0 && !from_inside) || (m.to != 0 && !to_inside))
+            {
+                INFO("Mapping of %s maps changed subtree out of itself", name);
+                return false;
+            }
+            if (m.from == 0 || m.to == 0)
+                --out.distance;
+            continue;
+        }
+        
+        if (m.to > r.old_id)
+            m.to = m.to - r.old_id + r.new_id;
+        out.map.push_back(m);
+    }
+    
+    for (const mapping::mapping_pair& m : sub.map)
+    {
+        // roots of subtrees are artificial
+        if (m.from == r.templ_size + 1 || m.to == r.new_size + 1)
+        {
+            if (m.from != r.templ_size + 1 || m.to != r.new_size + 1)
+                return false;
+            continue;
+        }
+        
+        out.map.push_back({m.from == 0 ? 0 : m.from + templ_first,
+                           m.to == 0 ? 0 : m.to + new_first});
+    }
+    sort(out.map.begin(), out.map.end());
+    
+    INFO("Subtree of %s x %s nodes matched again, distance %s -> %s",
+         r.templ_size, r.new_size, map.distance, out.distance);
+    
+    return true;
+}
+
+void layout_session::draw(
+                          const rna_tree& target,
+                          const mapping& m,
+                          const region* r)
+{
+    APP_DEBUG_FNAME;
+    
+    matcher match(templ.get_rna(), target);
+    rna_tree& out = match.run(m);
+    compact::iterators_vec edited = match.get_edited();
+    
+    if (r != nullptr)
+    {
+        // 0-based ids of new subtree are in [new_first, new_id)
+        size_t new_first = r->new_id - r->new_size;
+        vector<iterator> old_nodes(rna.size());
+        
+        for (iterator it = rna.begin(); it != rna.end(); ++it)
+            old_nodes.at(id(it)) = it;
+        
+        affine_transform t = fit(*r, old_nodes);
+        
+        for (iterator it = out.begin(); it != out.end(); ++it)
+        {
+            size_t k = id(it);
+            
+            if (k >= new_first && k < r->new_id)
+            {
+                // bases matched in subtree have template positions
+                for (size_t i = 0; i < it->size(); ++i)
+                    it->at(i).p = t(it->at(i).p);
+                continue;
+            }
+            
+            iterator old = old_nodes.at(k < new_first ? k : k - r->new_id + r->old_id);
+            
+            assert(old->size() == it->size());
+            for (size_t i = 0; i < it->size(); ++i)
+                it->at(i).p = old->at(i).p;
+            // loops out of subtree are already laid out
+            it->remake_ids.clear();
+        }
+        
+        edited.erase(remove_if(edited.begin(), edited.end(),
+                               [&](iterator it)
+                               {
+                                   return id(it) < new_first || id(it) >= r->new_id;
+                               }), edited.end());
+    }
+    
+    compact(out, edited, threads).run();
+    rna = out;
+}
+
+affine_transform layout_session::fit(
+                                     const region& r,
+                                     const std::vector<iterator>& old_nodes) const
+{
+    iterator from = templ_nodes.at(r.templ_id - 1);
+    iterator to = old_nodes.at(r.old_id - 1);
+    point t1 = from->at(0).p, t2 = from->at(1).p;
+    point s1 = to->at(0).p, s2 = to->at(1).p;
+    
+    if (t1.bad() || t2.bad() || s1.bad() || s2.bad())
+        return affine_transform();
+    
+    affine_transform out = affine_transform::translation(s1 - t1);
+    
+    if (!iszero(size(t2 - t1)) && !iszero(size(s2 - s1)))
+        out = affine_transform::rotation(s1, angle(s2 - s1) - angle(t2 - t1)) * out;
+    
+    // compact could have mirrored the branch
+    if (get_side(t1, t2, get_subtree_centre(from)) * get_side(s1, s2, get_subtree_centre(to)) < 0)
+        out = affine_transform::reflection(s1, s2) * out;
+    
+    return out;
+}
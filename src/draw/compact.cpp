@@ -19,6 +19,11 @@
  * USA.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "compact.hpp"
 #include "compact_circle.hpp"
 #include "compact_utils.hpp"
@@ -27,13 +32,79 @@
 using namespace std;
 
 #define MULTIBRANCH_MINIMUM_SPLIT   10
+// smaller work is not worth starting threads
+#define PARALLEL_MINIMUM_NODES      2000
+#define REPOSITION_TIME_BUDGET_MS   1000
+#define REPOSITION_ROTATION_ANGLE   30
 
 #define PAIRS_DISTANCE rna.get_pair_base_distance()
 #define BASES_DISTANCE rna.get_pairs_distance()
 
+/* local */ size_t get_depth(
+                             rna_tree::iterator it)
+{
+    size_t out = 0;
+    for (; !rna_tree::is_root(it); it = rna_tree::parent(it))
+        ++out;
+    return out;
+}
+
+/* local */ vector<size_t> sort_by_depth(
+                                         compact::iterators_vec& vec)
+{
+    vector<pair<size_t, compact::iterator>> depths;
+    vector<size_t> out;
+    
+    for (auto it : vec)
+        depths.push_back({get_depth(it), it});
+    stable_sort(depths.begin(), depths.end(),
+                [](const pair<size_t, compact::iterator>& p1, const pair<size_t, compact::iterator>& p2)
+                {
+                    return p1.first < p2.first;
+                });
+    for (size_t i = 0; i < vec.size(); ++i)
+    {
+        vec[i] = depths[i].second;
+        out.push_back(depths[i].first);
+    }
+    return out;
+}
+
+/* local */ size_t get_subtree_size(
+                                    rna_tree::iterator it)
+{
+    // ids are in postorder => subtree is continuous range of ids
+    // ending with `it` and starting with its leftmost leaf
+    rna_tree::iterator leftmost = it;
+    while (!rna_tree::is_leaf(leftmost))
+        leftmost = rna_tree::first_child(leftmost);
+    return id(it) - id(leftmost) + 1;
+}
+
+/* local */ rna_tree::iterator get_branch_end(
+                                              rna_tree::iterator it)
+{
+    rna_tree::sibling_iterator ch;
+    while (rna_tree::is_valid(ch = get_onlyone_branch(it)))
+        it = ch;
+    return it;
+}
+
 compact::compact(
-                 rna_tree& _rna)
-: rna(_rna)
+                 rna_tree& _rna,
+                 size_t _threads)
+: rna(_rna), threads(_threads)
+{
+    for (iterator it = rna.begin(); it != rna.end(); ++it)
+        if (is(it, rna_pair_label::inserted) || !it->remake_ids.empty())
+            edited.push_back(it);
+}
+
+compact::compact(
+                 rna_tree& _rna,
+                 const iterators_vec& _edited,
+                 size_t _threads)
+: rna(_rna), edited(_edited), threads(_threads)
 { }
 
 
@@ -45,8 +116,9 @@ void compact::run()
     
     init();
     make();
+    apply_all_pending();
     update_ends_in_rna(rna);
-    //    try_reposition_new_root_branches();
+    reposition_inserted_branches();
     checks();
     
     INFO("END: Computing RNA layout");
@@ -54,90 +126,48 @@ void compact::run()
 
 
 
-/* static */ void compact::shift_branch(
-                                        iterator parent,
-                                        point vector)
+void compact::shift_branch(
+                           iterator parent,
+                           point vector)
 {
-    function<size_t(iterator)> recursion =
-    [&recursion, &vector](iterator it) {
-        
-        sibling_iterator ch;
-        size_t out = 1;
-        
-        for (ch = it.begin(); ch != it.end(); ++ch)
-            out += recursion(ch);
-        
-        if (it->initiated_points())
-            for (size_t i = 0; i < it->size(); ++i)
-                it->at(i).p += vector;
-        
-        return out;
-    };
-    
-    recursion(parent);
+    transform_branch(parent, affine_transform::translation(vector));
 }
 
-/* static */ void compact::mirror_branch(
-                                         iterator root)
+void compact::mirror_branch(
+                            iterator root)
 {
-    //First we obtain direction vector of the root's bp (in case of
-    point pr[2] = {root->at(0).p, root->at(1).p};
-    point center_root = center(pr[0], pr[1]);
-    point v = pr[0] - pr[1];
-    
-    function<void(iterator)> recursion =
-    [&recursion, &pr](iterator it) {
-        
-        if (it->initiated_points())
-            for (size_t i = 0; i < it->size(); ++i) {
-                //Get the vector between mirror line and point
-                point p = it->at(i).p;
-                //double a = angle(p, center_root, center_root + v);
-                //Rotate the point in the reverse directions
-                //it->at(i).p += rotate(center_root, -a, distance(p, center_root));
-                
-                //http://stackoverflow.com/questions/3306838/algorithm-for-reflecting-a-point-across-a-line
-                //first project p on the mirror line
-                double a = (pr[0].y - pr[1].y) / (pr[0].x - pr[1].x);
-                double b = pr[0].y - pr[0].x * a;
-                //                        point pl(0 + (b * p.x) / (1 + m * m), b + (m * p.x) / (1 + m * m));
-                //                        it->at(i).p = 2 * pl - p;
-                double d = (p.x + (p.y - b)*a)/(1 + a*a);
-                it->at(i).p = point(2*d - p.x, 2*d*a - p.y + 2*b);
-                
-            }
-        
-        sibling_iterator ch;
-        
-        for (ch = it.begin(); ch != it.end(); ++ch)
-            recursion(ch);
-    };
+    apply_pending(root);
     
-    //Recursively mirror each point with respect to the line defined by the parent's center and direction vector
-    recursion(root);
+    // mirror line goes through both bases of the root's bp;
+    // reflection is computed from the line direction, so vertical lines work too
+    transform_branch(root, affine_transform::reflection(root->at(0).p, root->at(1).p));
 }
 
-/* static */ void compact::set_distance(
-                                        iterator parent,
-                                        iterator child,
-                                        double dist)
+void compact::set_distance(
+                           iterator parent,
+                           iterator child,
+                           double dist)
 {
     assert(rna_tree::parent(child) == parent);
     
+    apply_pending(parent);
     set_distance(child, parent->center(), dist);
 }
 
-/* static */ void compact::set_distance(
-                                        iterator it,
-                                        point from,
-                                        double dist)
+void compact::set_distance(
+                           iterator it,
+                           point from,
+                           double dist)
 {
+    apply_pending(it);
+    
     point p = it->center();
     point vec = normalize(p - from);
     double actual = distance(p, from);
     vec = vec * (dist - actual);
     
     shift_branch(it, vec);
+    apply_pending(it);
 }
 
 /* static */ bool compact::remake_child(
@@ -145,7 +175,7 @@ void compact::run()
                                         size_t n)
 {
     return is(parent, rna_pair_label::inserted) ||
-    contains(parent->remake_ids, n);
+    parent->remake_ids.contains(n);
 }
 
 /* static */ bool compact::to_remake_children(
@@ -156,24 +186,90 @@ void compact::run()
      is(parent, rna_pair_label::inserted));
 }
 
-/* static */ void compact::rotate_branch(
-                                         iterator it,
-                                         circle c,
-                                         double alpha)
+void compact::rotate_branch(
+                            iterator it,
+                            circle c,
+                            double alpha)
 {
     assert(!rna_tree::is_leaf(it));
     
-    for (pre_post_order_iterator ch = pre_post_order_iterator(it, true); id(ch) <= id(it); ++ch)
+    // every point of the branch turns around c.centre by the same angle
+    double beta = angle(c.rotate(alpha) - c.centre) - angle(c.p1 - c.centre);
+    
+    transform_branch(it, affine_transform::rotation(c.centre, beta));
+}
+
+void compact::transform_branch(
+                               iterator it,
+                               const affine_transform& t)
+{
+    if (rna_tree::is_leaf(it))
     {
-        if (!ch->initiated_points())
-            continue;
+        for (size_t i = 0; i < it->size(); ++i)
+            it->at(i).p = t(it->at(i).p);
+        return;
+    }
+    
+    affine_transform& tag = pending.at(id(it));
+    if (tag.identity())
+    {
+        lock_guard<mutex> lock(tagged_mutex);
+        tagged.push_back(it);
+    }
+    tag = t * tag;
+}
+
+void compact::push(
+                   iterator it)
+{
+    affine_transform& tag = pending.at(id(it));
+    
+    if (tag.identity())
+        return;
+    
+    for (size_t i = 0; i < it->size(); ++i)
+        it->at(i).p = tag(it->at(i).p);
+    
+    for (sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
+        transform_branch(ch, tag);
+    
+    tag = affine_transform();
+}
+
+void compact::apply_pending(
+                            iterator it)
+{
+    nodes_vec path;
+    
+    for (; !rna_tree::is_root(it); it = rna_tree::parent(it))
+        path.push_back(it);
+    path.push_back(it);
+    
+    for (auto node = path.rbegin(); node != path.rend(); ++node)
+        push(*node);
+}
+
+void compact::apply_all_pending()
+{
+    // outer subtrees first, nested tags are pushed with them
+    sort_by_depth(tagged);
+    
+    // pushing ancestors can tag new nodes => no iterators to `tagged`
+    for (size_t i = 0; i < tagged.size(); ++i)
+    {
+        iterator it = tagged[i];
         
-        double dist = distance(c.centre, ch->at(ch.label_index()).p);
-        c.p1 = ch->at(ch.label_index()).p;
-        c.p2 = move_point(c.centre, c.p2, dist);
+        if (pending.at(id(it)).identity())
+            continue;
         
-        ch->at(ch.label_index()).p = c.rotate(alpha);
+        apply_pending(it);
+        rna_tree::for_each_in_subtree(it,
+                                      [this](iterator ch)
+                                      {
+                                          push(ch);
+                                      });
     }
+    tagged.clear();
 }
 
 
@@ -183,13 +279,16 @@ void compact::init()
     
     assert(rna.is_ordered_postorder());
     
-    for (iterator it = ++rna.begin(); it != rna.end(); ++it)
-    { //traverse the tree pre-order
-        if (it->initiated_points() || !it->paired())
+    pending.assign(rna.size(), affine_transform());
+    
+    for (iterator it : edited)
+    { //traverse edited nodes pre-order
+        if (rna_tree::is_root(it) || it->initiated_points() || !it->paired())
             continue;
         
         //For non-initiated points or paired nodes, get their parents
         iterator par = rna_tree::parent(it);
+        apply_pending(par);
         point p = par->center();
         
         assert(!p.bad());
@@ -225,29 +324,33 @@ void compact::init()
     }
     
     init_even_branches();
+    apply_all_pending();
     
-    auto log = logger.debug_stream();
-    log << "Points initialization:\n";
-    auto f = [&](pre_post_order_iterator it)
+    if (logger.is_debug_enabled())
     {
-        if (it->paired())
+        auto log = logger.debug_stream();
+        log << "Points initialization:\n";
+        auto f = [&](pre_post_order_iterator it)
         {
-            if (it.preorder())
+            if (it->paired())
             {
-                mprintf("it[%s][%s = %s][%s = %s]\n", log,
+                if (it.preorder())
+                {
+                    mprintf("it[%s][%s = %s][%s = %s]\n", log,
+                            it->status,
+                            it->at(0).label(), it->at(0).p,
+                            it->at(1).label(), it->at(1).p);
+                }
+            }
+            else
+            {
+                mprintf("it[%s][%s = %s]\n", log,
                         it->status,
-                        it->at(0).label, it->at(0).p,
-                        it->at(1).label, it->at(1).p);
+                        it->at(0).label(), it->at(0).p);
             }
-        }
-        else
-        {
-            mprintf("it[%s][%s = %s]\n", log,
-                    it->status,
-                    it->at(0).label, it->at(0).p);
-        }
-    };
-    rna_tree::for_each_in_subtree(rna.begin_pre_post(), f);
+        };
+        rna_tree::for_each_in_subtree(rna.begin_pre_post(), f);
+    }
     
     // if first node was inserted and it is only one branch - do not remake it
     // because it shares parents (3'5' node) position: 3'-NODE1 <-> NODE2-5'
@@ -274,18 +377,29 @@ void compact::init()
 
 void compact::init_even_branches()
 {
-    // for nodes in one branch, set them to lie on a straight line
-    for (iterator it = rna.begin(); it != rna.end(); ++it)
+    // for nodes in one branch, set them to lie on a straight line;
+    // branch moves only its own subtree, so branches hanging
+    // from branching nodes of one generation are made even together
+    iterators_vec branching, branches;
+    
+    branching.push_back(get_branch_end(rna.begin()));
+    while (!branching.empty())
     {
-        if (rna_tree::is_leaf(it))
-            continue;
-        // run only when branching
-        if (!rna_tree::is_valid(get_onlyone_branch(it)))
-        {
+        branches.clear();
+        for (iterator it : branching)
             for (sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
                 if (!rna_tree::is_leaf(ch))
-                    make_branch_even(ch);
-        }
+                    branches.push_back(ch);
+        
+        for_each_subtree(branches,
+                         [this](iterator it)
+                         {
+                             make_branch_even(it);
+                         });
+        
+        branching.clear();
+        for (iterator it : branches)
+            branching.push_back(get_branch_end(it));
     }
 }
 
@@ -298,6 +412,7 @@ point compact::init_branch_recursive(
     
     if (it->initiated_points())
     {
+        apply_pending(it);
         p = normalize(it->center() - from) * BASES_DISTANCE;
         return p;
     }
@@ -312,6 +427,7 @@ point compact::init_branch_recursive(
         assert(ch->paired());
         
         shift_branch(it, p);
+        apply_pending(ch);
         it->at(0).p = ch->at(0).p - p;
         it->at(1).p = ch->at(1).p - p;
         
@@ -335,6 +451,7 @@ point compact::init_branch_recursive(
         {
             if (ch->initiated_points())
             {
+                apply_pending(ch);
                 p = it->center() - ch->center();
                 return p;
             }
@@ -358,6 +475,7 @@ point compact::init_branch_recursive(
     p = init_branch_recursive(ch);
     
     if (!p.bad()) {
+        apply_pending(ch);
         it->at(0).p = ch->at(0).p;
         it->at(1).p = ch->at(1).p;
         shift_branch(ch, -p);
@@ -375,6 +493,8 @@ void compact::init_by_ancestor(
     iterator par = rna_tree::parent(it);
     assert(!rna_tree::is_root(par));
     
+    apply_pending(it);
+    
     iterator grandpar = rna_tree::parent(par);
     if (!rna_tree::is_root(grandpar))
         vec = normalize(par->center() - rna_tree::parent(par)->center());
@@ -422,16 +542,20 @@ void compact::init_multibranch(
         if (init_branch_recursive(root, center).bad())
         {
             rna_tree::for_each_in_subtree(root,
-                                          [](iterator iter)
+                                          [this](iterator iter)
                                           {
-                                              rna_tree::parent(iter)->remake_ids.push_back(child_index(iter));
+                                              rna_tree::parent(iter)->remake_ids.insert(child_index(iter));
+                                              remade.push_back(rna_tree::parent(iter));
                                           });
             
+            apply_pending(root);
             root->at(0).p = p1;
             root->at(1).p = p2;
             return;
         }
         
+        apply_pending(root);
+        
         point rp1 = root->at(0).p;
         point rp2 = root->at(1).p;
         
@@ -439,19 +563,11 @@ void compact::init_multibranch(
         root->at(1).p = p2;
         
         double beta = angle(rp1 - rp2) - angle(p1 - p2);
+        // rotate descendants around rp1 and move rp1 to p1
+        affine_transform t = affine_transform::translation(p1 - rp1) * affine_transform::rotation(rp1, -beta);
         
-        for (pre_post_order_iterator it = ++pre_post_order_iterator(root, true); id(it) < id(root); ++it)
-        {
-            point from = it->at(it.label_index()).p;
-            if (from.bad())
-                continue;
-            
-            double alpha = angle(from - rp1);
-            double radius = distance(from, rp1);
-            
-            point to = rotate(p1, alpha - beta, radius);
-            it->at(it.label_index()).p = to;
-        }
+        for (sibling_iterator ch = root.begin(); ch != root.end(); ++ch)
+            transform_branch(ch, t);
     };
     
     if (root)  {
@@ -504,12 +620,14 @@ void compact::init_multibranch(
             
             point p1, p2;
             
+            apply_pending(first_initiated);
+            apply_pending(last_initiated);
             p1 = (*first_initiated)[0].p;
             last_initiated->paired() ? p2 = (*last_initiated)[1].p : p2 = (*last_initiated)[0].p;
             
             point c = center(p1, p2) - orthogonal(p1 - p2) * BASES_DISTANCE;
             //Testing whether it wouldn't be better to position the center in the opposite orthogonal direction
-            //is done later in the try_reposition_new_root_branches function
+            //is done later in the reposition_inserted_branches function
             
             /*
              * We need to remember the parent's center be used later when initializing position for the child of current node.
@@ -565,6 +683,8 @@ void compact::init_multibranch(
             
             point p1, p2;
             
+            apply_pending(prev);
+            apply_pending(next);
             prev->paired() ? p1 = (*prev)[1].p : p1 = (*prev)[0].p;
             p2 = (*next)[0].p;
             
@@ -575,7 +695,7 @@ void compact::init_multibranch(
             
             point c = center(p1, p2) - orthogonal(p2 - p1) * BASES_DISTANCE;
             //Whether it wouldn't be better to position the center in the opposite orthogonal direction
-            //is checked later in the try_reposition_new_root_branches function
+            //is checked later in the reposition_inserted_branches function
             
             /*
              * We need to remember the parent's center be used later when intializing position for the child of current node.
@@ -612,6 +732,7 @@ void compact::init_multibranch(
         
         //Move the existing branch in its current direction so that there is enough space for the new branch
         //to be located perpendicular to it
+        apply_pending(it_existing);
         point p[2] = {it->at(0).p, it->at(1).p};
         point e[2] = {it_existing->at(0).p, it_existing->at(1).p};
         point c_parent = center(p[0], p[1]);
@@ -626,6 +747,8 @@ void compact::init_multibranch(
         rotate_subtree(it_new, c_junction, points_new[0], points_new[1]);
         
     } else {
+        apply_pending(it);
+        
         circle c;
         c.p1 = it->at(0).p;
         c.p2 = it->at(1).p;
@@ -681,6 +804,10 @@ void compact::make_branch_even(
     if (vec.size() < 2)
         return;
     
+    // whole stem with its leaves is valid afterwards,
+    // only subtrees below vec.back() can keep pending transforms
+    apply_pending(vec.back());
+    
     p1 = vec[0]->at(0).p;
     p2 = vec[0]->at(1).p;
     if (!double_equals(distance(p1, p2), BASES_DISTANCE))
@@ -737,19 +864,45 @@ void compact::make()
 {
     APP_DEBUG_FNAME;
     
-    iterator it;
-    intervals in;
+    iterators_vec work = edited, level;
+    vector<size_t> depths;
+    vector<bool> done(rna.size(), false);
     
-    for (it = rna.begin(); it != rna.end(); ++it)
+    work.insert(work.end(), remade.begin(), remade.end());
+    // remaking a loop moves subtrees of its branches,
+    // so ancestors have to be remade before descendants;
+    // loops in the same depth lie in disjoint subtrees
+    depths = sort_by_depth(work);
+    
+    for (size_t i = 0; i < work.size();)
     {
-        if (!to_remake_children(it))
-            continue;
+        level.clear();
+        for (size_t depth = depths[i]; i < work.size() && depths[i] == depth; ++i)
+        {
+            iterator it = work[i];
+            
+            if (done.at(id(it)) || !to_remake_children(it))
+                continue;
+            
+            done.at(id(it)) = true;
+            apply_pending(it);
+            level.push_back(it);
+        }
         
-        in.init(it);
-        set_distances(in);
-        for (auto& i : in.vec)
-            if (i.remake)
-                remake(i, in.get_circle_direction());
+        for_each_subtree(level,
+                         [this](iterator it)
+                         {
+                             intervals in;
+                             
+                             for (sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
+                                 push(ch);
+                             
+                             in.init(it);
+                             set_distances(in);
+                             for (auto& i : in.vec)
+                                 if (i.remake)
+                                     remake(i, in.get_circle_direction());
+                         });
     }
 }
 
@@ -931,56 +1084,189 @@ double compact::get_length(
 
 /* inline */ void compact::checks()
 {
-    // all but root should be inited
-    for (iterator it = ++rna.begin(); it != rna.end(); ++it)
+    // all but root should be inited,
+    // other nodes than edited ones kept points from template
+    for (iterator it : edited)
     {
-        if (!it->initiated_points())
+        if (!rna_tree::is_root(it) && !it->initiated_points())
         {
             ERR("Some bases positions were not initialized and therefore not drawn.");
         }
     }
 }
 
-void compact::try_reposition_new_root_branches()
+void compact::for_each_subtree(
+                               const iterators_vec& roots,
+                               const function<void(iterator)>& f)
 {
+    size_t nodes = 0;
+    size_t workers = min(threads, roots.size());
     
-    overlap_checks::overlaps overlaps = overlap_checks().run(rna);
+    for (iterator it : roots)
+        nodes += get_subtree_size(it);
     
-    sibling_iterator root = rna.begin();
-    for (sibling_iterator it = root.begin(); it != root.end(); ++it)
+    if (workers < 2 || nodes < PARALLEL_MINIMUM_NODES)
+    {
+        for (iterator it : roots)
+            f(it);
+        return;
+    }
+    
+    atomic<size_t> next_root(0);
+    exception_ptr error;
+    mutex error_mutex;
+    
+    auto worker = [&]()
+    {
+        size_t i;
+        
+        while ((i = next_root++) < roots.size())
+        {
+            try
+            {
+                f(roots[i]);
+            }
+            catch (...)
+            {
+                lock_guard<mutex> lock(error_mutex);
+                if (error == nullptr)
+                    error = current_exception();
+                next_root = roots.size();
+            }
+        }
+    };
+    
+    vector<thread> pool;
+    for (size_t t = 1; t < workers; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool)
+        t.join();
+    
+    if (error != nullptr)
+        rethrow_exception(error);
+}
+
+void compact::reposition_inserted_branches()
+{
+    APP_DEBUG_FNAME;
+    
+    typedef overlap_checks::edges edges;
+    
+    // only tops of inserted branches, nested ones move with them
+    auto is_inserted_top = [](iterator it)
+    {
+        return it->paired() && is(it, rna_pair_label::inserted) &&
+        !is(rna_tree::parent(it), rna_pair_label::inserted);
+    };
+    
+    if (none_of(edited.begin(), edited.end(), is_inserted_top))
+        return;
+    
+    auto deadline = chrono::steady_clock::now() +
+    chrono::milliseconds(REPOSITION_TIME_BUDGET_MS);
+    
+    // backbone of all bases but 5'/3' ends; bases of pair `it`
+    // are backbone[first[id(it)]] and backbone[last[id(it)]]
+    points_vec backbone;
+    vector<size_t> first(rna.size()), last(rna.size());
+    
+    for (pre_post_order_iterator it = rna.begin_pre_post(); it != rna.end_pre_post(); ++it)
+    {
+        if (rna_tree::is_root(it))
+            continue;
+        
+        (it.preorder() ? first : last).at(id(it)) = backbone.size();
+        backbone.push_back(it->at(it.label_index()).p);
+    }
+    
+    edges all(backbone.size() < 2 ? 0 : backbone.size() - 1);
+    for (size_t i = 0; i < all.size(); ++i)
+        all[i] = {backbone[i], backbone[i + 1]};
+    
+    overlap_checks::edge_grid grid(all);
+    
+    // edges [first, last) of branch moved by `t`, pair bases stay fixed
+    auto move_edges = [&](iterator it, const affine_transform& t)
     {
-        if (it->paired() && it->status == rna_pair_label::inserted)
-        {//newly inserted pair (not neccessary whole new branch)
+        size_t b = first[id(it)], e = last[id(it)];
+        edges out(e - b);
+        
+        for (size_t i = b; i < e; ++i)
+        {
+            out[i - b].p1 = i == b ? backbone[i] : t(backbone[i]);
+            out[i - b].p2 = i + 1 == e ? backbone[i + 1] : t(backbone[i + 1]);
+        }
+        return out;
+    };
+    
+    size_t before = 0, after = 0, moved = 0;
+    
+    for (iterator it : edited)
+    {
+        if (!is_inserted_top(it))
+            continue;
+        
+        if (chrono::steady_clock::now() > deadline)
+        {
+            INFO("Repositioning branches stopped, time budget exceeded");
+            break;
+        }
+        
+        size_t b = first[id(it)];
+        size_t count = overlap_checks::count_overlaps(all, grid, b, move_edges(it, affine_transform()));
+        
+        before += count;
+        if (count == 0)
+            continue;
+        
+        point p1 = backbone[b], p2 = backbone[last[id(it)]];
+        point c = center(p1, p2);
+        vector<affine_transform> alternatives = {
+            affine_transform::reflection(p1, p2),
+            affine_transform::rotation(c, REPOSITION_ROTATION_ANGLE),
+            affine_transform::rotation(c, -REPOSITION_ROTATION_ANGLE),
+        };
+        
+        affine_transform best;
+        edges best_edges;
+        for (const affine_transform& t : alternatives)
+        {
+            edges e = move_edges(it, t);
+            size_t n = overlap_checks::count_overlaps(all, grid, b, e);
             
-            //Try to mirror the branch
-            mirror_branch(it);
-            //Get the number of overlaps
-            //TODO: should be optimized to check only intersections in the current branch
-            overlap_checks::overlaps overlaps_aux = overlap_checks().run(rna);
-            //If by mirroring we got more overlaps, mirror back
-            if (overlaps_aux.size() > overlaps.size()) mirror_branch(it);
+            // ties keep the layout made by compact
+            if (n < count)
+            {
+                count = n;
+                best = t;
+                best_edges = e;
+            }
+        }
+        
+        after += count;
+        if (best.identity())
+            continue;
+        
+        DEBUG("Repositioning branch %s", clabel(it));
+        ++moved;
+        
+        // branch can lie in already moved one, its transform goes first
+        for (sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
+        {
+            apply_pending(ch);
+            transform_branch(ch, best);
+        }
+        
+        for (size_t i = 0; i < best_edges.size(); ++i)
+        {
+            grid.move(b + i, all[b + i], best_edges[i]);
+            all[b + i] = best_edges[i];
+            backbone[b + i + 1] = best_edges[i].p2;
         }
     }
-    //    sibling_iterator root = rna.begin();
-    //
-    //    overlap_checks::edges edges_all = overlap_checks::get_edges(root);
-    //
-    //    for (sibling_iterator it = root.begin(); it != root.end(); ++it)
-    //    {
-    //        if (it->paired() && it->status == rna_pair_label::inserted)
-    //        {//newly inserted pair (not neccessary whole new branch)
-    //            overlap_checks::edges edges_branch = overlap_checks::get_edges(it);
-    //
-    //            overlap_checks::overlaps overlaps1 = overlap_checks::get_overlaps(edges_all,edges_branch);
-    //
-    //            //Try to mirror the branch
-    //            mirror_branch(it);
-    //            //Get the number of overlaps
-    //            //TODO: should be optimized to check only intersections in the current branch
-    //            //overlap_checks::overlaps overlaps_aux = overlap_checks().run(rna);
-    //            overlap_checks::overlaps overlaps2 = overlap_checks::get_overlaps(edges_all,edges_branch);
-    //            //If by mirroring we got more overlaps, mirror back
-    //            if (overlaps2.size() > overlaps1.size()) mirror_branch(it);
-    //        }
-    //    }
+    apply_all_pending();
+    
+    INFO("Repositioned %s inserted branches, their overlaps: %s -> %s",
+         moved, before, after);
 }
@@ -20,6 +20,8 @@
  */
 
 
+#include <complex>
+
 #include "compact_circle.hpp"
 
 using namespace std;
@@ -43,6 +45,51 @@ assert(sgn == 1 || sgn == -1)
 #define BASES_RATIO                 1.
 #define BASES_DISTANCE_PRECISION    2.
 
+#define NEWTON_ITERATIONS           100
+#define NEWTON_PRECISION            1e-12
+#define SEARCH_ITERATIONS           100
+#define SEARCH_SHIFT                15.
+
+/**
+ * signed distance of centre from the middle of chord (along the axis
+ * pointing away from the arc), so that arc over `chord` has `length`;
+ * -HUGE_VAL when the arc can not be that short
+ *
+ * For arc with central angle 2 * phi:
+ *      radius = chord / (2 * sin(phi)),
+ *      length = chord * phi / sin(phi)
+ * so phi is the root of f(phi) = phi / sin(phi) - ratio, on (0, PI).
+ * f is increasing and convex there, Newton steps starting right
+ * of the root converge monotonically.
+ */
+/* local */ double centre_shift(
+                                double chord,
+                                double length)
+{
+    double ratio = length / chord;
+    
+    if (ratio <= 1.)
+        return -HUGE_VAL;
+    
+    // f(PI * ratio / (ratio + 1)) >= 0, because sin(x) <= x
+    double phi = M_PI * ratio / (ratio + 1);
+    for (size_t i = 0; i < NEWTON_ITERATIONS; ++i)
+    {
+        double sin_phi = sin(phi);
+        double f = phi / sin_phi - ratio;
+        double df = (sin_phi - phi * cos(phi)) / (sin_phi * sin_phi);
+        double step = f / df;
+        
+        phi -= step;
+        
+        if (fabs(step) < NEWTON_PRECISION)
+            break;
+    }
+    
+    // cos(phi) may be 0
+    return -chord / (2 * sin(phi)) * cos(phi);
+}
+
 /* static */ double compact::circle::min_circle_length(
                                                        size_t nodes_count,
                                                        double loops_bases_distance)
@@ -130,11 +177,21 @@ point compact::circle::rotate(
 std::vector<point> compact::circle::split(
                                           size_t n) const
 {
+    CIRCLE_POINTS_INITED();
+    CIRCLE_SGN_INITED();
+    
     vector<point> vec;
-    double delta = segment_angle() / (double)(n + 1);
+    double delta = degrees_to_radians(segment_angle()) / (double)(n + 1);
+    // rotate p1 around centre step by step, no trigonometry per point
+    complex<double> step = polar(1., sgn * delta);
+    complex<double> z(p1.x - centre.x, p1.y - centre.y);
     
+    vec.reserve(n);
     for (size_t i = 1; i <= n; ++i)
-        vec.push_back(rotate(delta * i));
+    {
+        z *= step;
+        vec.push_back({centre.x + z.real(), centre.y + z.imag()});
+    }
     
     return vec;
 }
@@ -171,42 +228,73 @@ std::vector<point> compact::circle::init(
     
     DEBUG("Initialize circle for %s nodes", n);
     
-    size_t max_iterations = 100;
-    double needed_length, actual_length, shift_size;
-    point shift;
+    /*
+     * Centre moves on the axis of chord p1-p2 from its middle, the arc lies
+     * on the side opposite to `direction` and gets longer as centre moves
+     * along `axis`. Length grows with the shift, so the needed length and
+     * its BASES_DISTANCE_PRECISION bounds are three shifts.
+     *
+     * Any shift in (lower, upper) is precise enough, but shape of nearly
+     * flat arcs depends on it a lot; the shift is the one the original
+     * search stopped at: it walked from the middle of chord towards `needed`
+     * by SEARCH_SHIFT steps and halved the step whenever it got past
+     * `needed`. Its constant steps are counted at once, only the halving
+     * steps around `needed` are walked.
+     */
+    double needed_length, chord, needed, lower, upper;
+    double shift, shift_size, bound;
+    size_t steps;
+    point axis;
     bool lt;
     
     needed_length = min_circle_length(n, loops_bases_distance) + BASES_DISTANCE_PRECISION;
-    actual_length = segment_length();
-    shift_size = 15;
-    shift = -normalize(orthogonal(p2 - p1, direction - p1));
+    chord = distance(p1, p2);
+    axis = -orthogonal(p2 - p1, direction - p1);
+    
+    needed = centre_shift(chord, needed_length);
+    lower = centre_shift(chord, needed_length - BASES_DISTANCE_PRECISION);
+    upper = centre_shift(chord, needed_length + BASES_DISTANCE_PRECISION);
     
-    while (--max_iterations > 0)
+    shift = 0;
+    shift_size = SEARCH_SHIFT;
+    steps = 0;
+    
+    if (!(shift > lower && shift < upper))
     {
-        if (double_equals_precision(actual_length, needed_length,
-                                    BASES_DISTANCE_PRECISION))
-            break;
-        
-        shift = normalize(shift) * shift_size;
-        
-        if (actual_length < needed_length)
-        {
-            centre = centre + shift;
-            lt = true;
-        }
-        else
+        // constant steps end with the first one past near bound of (lower, upper)
+        lt = shift < needed;
+        bound = lt ? lower : -upper;
+        steps = SEARCH_ITERATIONS - 1;
+        if (bound < steps * SEARCH_SHIFT)
         {
-            centre = centre - shift;
-            lt = false;
+            steps = max<size_t>(1, bound / SEARCH_SHIFT);
+            while (steps > 1 && (steps - 1) * SEARCH_SHIFT > bound)
+                --steps;
+            while (steps * SEARCH_SHIFT <= bound)
+                ++steps;
         }
-        actual_length = segment_length();
         
-        if ((lt && actual_length > needed_length) ||
-            (!lt && actual_length < needed_length))
+        shift = lt ? steps * SEARCH_SHIFT : -(steps * SEARCH_SHIFT);
+        if ((lt && shift > needed) ||
+            (!lt && shift < needed))
             shift_size /= 2.0;
     }
-    if (max_iterations == 0)
-        DEBUG("max_iterations reached");
+    
+    for (size_t i = steps + 1; i < SEARCH_ITERATIONS; ++i)
+    {
+        if (shift > lower && shift < upper)
+            break;
+        
+        lt = shift < needed;
+        shift += lt ? shift_size : -shift_size;
+        
+        if ((lt && shift > needed) ||
+            (!lt && shift < needed))
+            shift_size /= 2.0;
+    }
+    
+    point middle = ::center(p1, p2);
+    centre = {middle.x + axis.x * shift, middle.y + axis.y * shift};
     
     return split(n);
 }
@@ -65,8 +65,7 @@ void compact::intervals::init(
     vec.back().end = {parent, 1};
     
     if (!parent->remake_ids.empty())
-        if (*std::max_element(parent->remake_ids.begin(),
-                              parent->remake_ids.end()) >= i)
+        if (parent->remake_ids.max() >= i)
             vec.back().remake = true;
     
     if (is(parent, rna_pair_label::inserted))
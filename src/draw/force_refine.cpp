@@ -0,0 +1,377 @@
+/*
+ * File: force_refine.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#include <algorithm>
+#include <chrono>
+
+#include "force_refine.hpp"
+#include "overlap_checks.hpp"
+
+using namespace std;
+
+#define REFINE_TIME_BUDGET_MS       2000
+// bases closer than RATIO * (smallest usual distance) repel each other
+#define REPULSION_RADIUS_RATIO      0.9
+#define SPRING_STRENGTH             1.
+#define ANGLE_SPRING_STRENGTH       0.5
+// shift of base is force * STEP, limited by temperature
+#define STEP                        0.25
+#define INITIAL_TEMPERATURE_RATIO   0.5
+// ends of crossing edges are pushed `radius * RATIO` beyond the other edge
+#define CROSSING_MARGIN_RATIO       0.5
+#define CROSSING_STRENGTH           1.
+// grid has at most RATIO * (number of points) cells
+#define GRID_MAXIMUM_CELLS_RATIO    4
+
+struct force_refine::grid
+{
+    /**
+     * points are bucketed to cells of size at least `radius`,
+     * so all points closer than `radius` lie in neighbouring cells
+     */
+    grid(
+         const points_vec& _points,
+         double radius);
+    
+    /**
+     * sum of repulsive forces acting on point `i` from points closer than `radius`
+     */
+    point repulsion(
+                    size_t i,
+                    double radius) const;
+    
+private:
+    size_t cell_x(
+                  double x) const;
+    size_t cell_y(
+                  double y) const;
+    
+private:
+    const points_vec& points;
+    point origin;
+    double cell_size;
+    size_t columns, rows;
+    // points of cell `c` are order[first[c]] .. order[first[c + 1] - 1]
+    std::vector<size_t> first;
+    std::vector<size_t> order;
+};
+
+
+force_refine::grid::grid(
+                         const points_vec& _points,
+                         double radius)
+: points(_points)
+{
+    point low = points.empty() ? point(0, 0) : points[0];
+    point high = low;
+    
+    for (const point& p : points)
+    {
+        low = point(min(low.x, p.x), min(low.y, p.y));
+        high = point(max(high.x, p.x), max(high.y, p.y));
+    }
+    
+    cell_size = radius;
+    while ((high.x - low.x) / cell_size * (high.y - low.y) / cell_size >
+           GRID_MAXIMUM_CELLS_RATIO * (points.size() + 1))
+        cell_size *= 2;
+    
+    origin = low;
+    columns = (size_t)((high.x - low.x) / cell_size) + 1;
+    rows = (size_t)((high.y - low.y) / cell_size) + 1;
+    
+    // counting sort of points by cells
+    vector<size_t> cells(points.size());
+    first.assign(columns * rows + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        cells[i] = cell_y(points[i].y) * columns + cell_x(points[i].x);
+        ++first[cells[i] + 1];
+    }
+    for (size_t c = 0; c < columns * rows; ++c)
+        first[c + 1] += first[c];
+    
+    vector<size_t> next(first.begin(), first.end() - 1);
+    order.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        order[next[cells[i]]++] = i;
+}
+
+size_t force_refine::grid::cell_x(
+                                  double x) const
+{
+    double c = floor((x - origin.x) / cell_size);
+    return (size_t)max(0., min(c, (double)columns - 1));
+}
+
+size_t force_refine::grid::cell_y(
+                                  double y) const
+{
+    double c = floor((y - origin.y) / cell_size);
+    return (size_t)max(0., min(c, (double)rows - 1));
+}
+
+point force_refine::grid::repulsion(
+                                    size_t i,
+                                    double radius) const
+{
+    const point& p = points[i];
+    double fx = 0, fy = 0;
+    
+    size_t x1 = cell_x(p.x - radius), x2 = cell_x(p.x + radius);
+    size_t y1 = cell_y(p.y - radius), y2 = cell_y(p.y + radius);
+    
+    for (size_t y = y1; y <= y2; ++y)
+        for (size_t x = x1; x <= x2; ++x)
+            for (size_t k = first[y * columns + x]; k < first[y * columns + x + 1]; ++k)
+            {
+                // linear force (radius - distance) pushing `p` away from `q`
+                const point& q = points[order[k]];
+                double dx = p.x - q.x, dy = p.y - q.y;
+                double d = sqrt(dx * dx + dy * dy);
+        
+                if (order[k] == i || d >= radius || iszero(d))
+                    continue;
+                fx += dx / d * (radius - d);
+                fy += dy / d * (radius - d);
+            }
+    
+    return point(fx, fy);
+}
+
+
+force_refine::force_refine(
+                           rna_tree& _rna,
+                           size_t _iterations)
+: rna(_rna), iterations(_iterations)
+{
+    typedef rna_tree::pre_post_order_iterator pre_post_order_iterator;
+    
+    // pairs are nested, postorder visit closes the last opened pair
+    vector<size_t> opened;
+    
+    for (pre_post_order_iterator it = rna.begin_pre_post(); it != rna.end_pre_post(); ++it)
+    {
+        if (rna_tree::is_root(it) || !it->initiated_points())
+            continue;
+        
+        rna_label& label = it->at(it.label_index());
+        
+        if (it->paired() && it.preorder())
+            opened.push_back(labels.size());
+        else if (it->paired())
+        {
+            size_t partner = opened.back();
+            opened.pop_back();
+            springs.push_back({partner, labels.size(), distance(points[partner], label.p), SPRING_STRENGTH});
+        }
+        
+        labels.push_back(&label);
+        points.push_back(label.p);
+        movable.push_back(contains({rna_pair_label::inserted,
+                                    rna_pair_label::reinserted,
+                                    rna_pair_label::rotated}, it->status));
+    }
+    
+    for (size_t i = 0; i + 1 < points.size(); ++i)
+    {
+        springs.push_back({i, i + 1, distance(points[i], points[i + 1]), SPRING_STRENGTH});
+        if (i + 2 < points.size())
+            springs.push_back({i, i + 2, distance(points[i], points[i + 2]), ANGLE_SPRING_STRENGTH});
+    }
+    
+    // springs between pinned bases do nothing
+    springs.erase(remove_if(springs.begin(), springs.end(),
+                            [this](const spring& s)
+                            {
+                                return !movable[s.from] && !movable[s.to];
+                            }), springs.end());
+    
+    radius = REPULSION_RADIUS_RATIO * min({rna.get_pairs_distance(),
+                                           rna.get_pair_base_distance(),
+                                           rna.get_loops_bases_distance()});
+}
+
+void force_refine::run()
+{
+    APP_DEBUG_FNAME;
+    
+    INFO("BEG: Refining layout of RNA %s", rna.name());
+    
+    size_t moving = count(movable.begin(), movable.end(), true);
+    if (moving == 0 || !(radius > 0))
+    {
+        INFO("END: Refining layout, nothing to refine");
+        return;
+    }
+    
+    points_vec initial = points;
+    size_t before = count_overlaps(points);
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(REFINE_TIME_BUDGET_MS);
+    size_t i;
+    
+    for (i = 0; i < iterations && chrono::steady_clock::now() < deadline; ++i)
+    {
+        // cooling, last steps only polish the layout
+        step(INITIAL_TEMPERATURE_RATIO * radius * (iterations - i) / iterations);
+    }
+    
+    size_t after = count_overlaps(points);
+    
+    if (after > before)
+    {
+        points = initial;
+        INFO("Refined layout has more overlaps (%s > %s), it is discarded", after, before);
+    }
+    else
+    {
+        for (size_t k = 0; k < points.size(); ++k)
+            labels[k]->p = points[k];
+    }
+    
+    INFO("END: Refining layout: %s bases moved in %s iterations, overlaps %s -> %s",
+         moving, i, before, min(before, after));
+}
+
+void force_refine::step(
+                        double temperature)
+{
+    grid g(points, radius);
+    vector<point> forces(points.size(), point(0, 0));
+    
+    for (size_t i = 0; i < points.size(); ++i)
+        if (movable[i])
+            forces[i] = g.repulsion(i, radius);
+    
+    add_crossing_forces(forces);
+    
+    for (const spring& s : springs)
+    {
+        point v = points[s.to] - points[s.from];
+        double d = size(v);
+        
+        if (iszero(d))
+            continue;
+        
+        // positive pulls bases together
+        double f = s.strength * (d - s.length) / d;
+        forces[s.from] += point(v.x * f, v.y * f);
+        forces[s.to] -= point(v.x * f, v.y * f);
+    }
+    
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        if (!movable[i])
+            continue;
+        
+        point shift = point(forces[i].x * STEP, forces[i].y * STEP);
+        double d = size(shift);
+        
+        if (d > temperature)
+            shift = point(shift.x * temperature / d, shift.y * temperature / d);
+        
+        points[i] += shift;
+    }
+}
+
+void force_refine::add_crossing_forces(
+                                       points_vec& forces) const
+{
+    overlap_checks::edges e;
+    
+    for (size_t i = 0; i + 1 < points.size(); ++i)
+        e.push_back({points[i], points[i + 1]});
+    
+    // moves the movable end of edge `i` (the one closer to line of edge `j`)
+    // beyond that line, to the side of the other end
+    auto push = [&](size_t i, size_t j)
+    {
+        point n = orthogonal(e[j].p2 - e[j].p1);
+        auto side = [&](const point& p)
+        {
+            return (p.x - e[j].p1.x) * n.x + (p.y - e[j].p1.y) * n.y;
+        };
+        double s1 = side(points[i]), s2 = side(points[i + 1]);
+        size_t u;
+        
+        if (movable[i] && (!movable[i + 1] || fabs(s1) < fabs(s2)))
+            u = i;
+        else if (movable[i + 1])
+            u = i + 1;
+        else
+            return;
+        
+        double s = u == i ? s1 : s2, other = u == i ? s2 : s1;
+        double f = CROSSING_STRENGTH * (fabs(s) + CROSSING_MARGIN_RATIO * radius);
+        
+        if (other < 0)
+            f = -f;
+        forces[u] += point(n.x * f, n.y * f);
+    };
+    
+    overlap_checks::edge_grid grid(e);
+    vector<size_t> candidates, crossing;
+    overlap_checks::edges_array batch;
+    vector<point> intersections;
+    
+    for (size_t i = 0; i < e.size(); ++i)
+    {
+        if (!movable[i] && !movable[i + 1])
+            continue;
+        
+        grid.candidates(e[i], candidates);
+        batch.clear();
+        crossing.clear();
+        
+        for (size_t j : candidates)
+        {
+            // neighbours share end points, crossings of two movable edges
+            // are found from the first one
+            if (j + 1 >= i && j <= i + 1)
+                continue;
+            if (j < i && (movable[j] || movable[j + 1]))
+                continue;
+            batch.push_back(e[j]);
+            crossing.push_back(j);
+        }
+        
+        overlap_checks::intersections(e[i], batch, intersections);
+        
+        for (size_t k = 0; k < crossing.size(); ++k)
+        {
+            if (intersections[k].bad())
+                continue;
+            push(i, crossing[k]);
+            push(crossing[k], i);
+        }
+    }
+}
+
+/* static */ size_t force_refine::count_overlaps(
+                                                 const points_vec& p)
+{
+    overlap_checks::edges e;
+    
+    for (size_t i = 0; i + 1 < p.size(); ++i)
+        e.push_back({p[i], p[i + 1]});
+    
+    return overlap_checks::count_overlaps(e);
+}
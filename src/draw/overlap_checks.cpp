@@ -24,6 +24,20 @@
 
 using namespace std;
 
+#define GRID_MAXIMUM_CELLS_RATIO    4
+
+/**
+ * edges sharing end points (also coincident ones) are not intersecting
+ */
+/* local */ bool touching_edges(
+                                const overlap_checks::edge& e1,
+                                const overlap_checks::edge& e2)
+{
+    return e1.p1 == e1.p2 || e2.p1 == e2.p2 ||
+    contains({e1.p1, e1.p2}, e2.p1) ||
+    contains({e1.p1, e1.p2}, e2.p2);
+}
+
 
 overlap_checks::overlap_checks()
 { }
@@ -50,6 +64,8 @@ overlap_checks::edges overlap_checks::get_edges(
     edges vec;
     edge e;
     
+    // layout is changed through iterators, so flat snapshot of rna would have
+    // to be built again for each call; walking the tree is cheaper
 #define get_p() it->at(it.label_index()).p
     rna_tree::pre_post_order_iterator it = ++rna.begin_pre_post();
     e.p1 = get_p();
@@ -73,25 +89,36 @@ overlap_checks::overlaps overlap_checks::run(
 {
     APP_DEBUG_FNAME;
     
-    edge e1, e2;
-    point p;
     vector<overlapping> vec;
+    edge_grid grid(e);
+    vector<size_t> candidates;
+    edges_array batch;
+    vector<point> points;
     
     for (size_t i = 0; i < e.size(); ++i)
     {
-        e1 = e[i];
+        grid.candidates(e[i], candidates);
+        // neighbours share end points
+        candidates.erase(remove_if(candidates.begin(), candidates.end(),
+                                   [i](size_t j) { return j < i + 2; }),
+                         candidates.end());
+        sort(candidates.begin(), candidates.end());
+        
+        batch.clear();
+        for (size_t j : candidates)
+            batch.push_back(e[j]);
+        intersections(e[i], batch, points);
         
-        for (size_t j = i + 2; j < e.size(); ++j)
+        for (size_t k = 0; k < candidates.size(); ++k)
         {
-            e2 = e[j];
-            
-            p = intersection(e1, e2);
+            const point& p = points[k];
+            const edge& e2 = e[candidates[k]];
             
             if (!p.bad())
             {
                 auto distances = {
-                    distance(p, e1.p1),
-                    distance(p, e1.p2),
+                    distance(p, e[i].p1),
+                    distance(p, e[i].p2),
                     distance(p, e2.p1),
                     distance(p, e2.p2),
                 };
@@ -104,50 +131,124 @@ overlap_checks::overlaps overlap_checks::run(
     return vec;
 }
 
+/**
+ * point of proper crossing of a -> b with c -> d, signs of orientations
+ * are already known, so parameter `t` is clamped against rounding
+ */
+/* local */ point crossing_point(
+                                 const point& a,
+                                 const point& b,
+                                 const point& c,
+                                 const point& d)
+{
+    double oa = (d.x - c.x) * (a.y - c.y) - (d.y - c.y) * (a.x - c.x);
+    double ob = (d.x - c.x) * (b.y - c.y) - (d.y - c.y) * (b.x - c.x);
+    double t = oa == ob ? 0.5 : oa / (oa - ob);
+    
+    t = min(1., max(0., t));
+    
+    return point(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y));
+}
+
+/* local */ bool same_point(
+                            const point& p1,
+                            const point& p2)
+{
+    return p1.x == p2.x && p1.y == p2.y;
+}
+
 /* static */ point overlap_checks::intersection(
                                                 const edge& e1,
                                                 const edge& e2)
 {
-    // a / sin(alpha) == b / sin(beta) == c / sin(gamma)
-    // => a = c * sin(alpha) / sin(gamma)
-    //
-    double alpha, beta, gamma;
-    double a, c;
-    point p;
-    
-    assert(!contains<vector<point>>({e1.p1, e1.p2}, e2.p1));
-    assert(!contains<vector<point>>({e1.p1, e1.p2}, e2.p2));
+    const point& a = e1.p1;
+    const point& b = e1.p2;
+    const point& c = e2.p1;
+    const point& d = e2.p2;
     
-    c = distance(e1.p1, e2.p1);
+    int oa = orientation(c, d, a);
+    int ob = orientation(c, d, b);
+    int oc = orientation(a, b, c);
+    int od = orientation(a, b, d);
     
-    alpha = angle(e2.p1, e1.p1, e1.p2);
-    beta = angle(e1.p1, e2.p1, e2.p2);
+    // collinear edges or both end points of one edge on the same side of other
+    if ((oa == 0 && ob == 0) ||
+        oa * ob > 0 || oc * od > 0)
+        return point::bad_point();
     
-    if (alpha > 180)
-        alpha = 360. - alpha;
-    if (beta > 180)
-        beta = 360. - beta;
+    if (same_point(a, c) || same_point(a, d) ||
+        same_point(b, c) || same_point(b, d))
+        return point::bad_point();
     
-    gamma = 180. - alpha - beta;
+    // end point lies inside of the other edge
+    if (oa == 0)
+        return a;
+    if (ob == 0)
+        return b;
+    if (oc == 0)
+        return c;
+    if (od == 0)
+        return d;
     
-    assert(double_equals(180, alpha + beta + gamma));
+    return crossing_point(a, b, c, d);
+}
+
+/* static */ void overlap_checks::intersections(
+                                                const edge& e,
+                                                const edges_array& batch,
+                                                std::vector<point>& out)
+{
+    // status has the same width as coordinates, otherwise the loop
+    // mixes vector sizes and it is not vectorized
+    const double apart = 0, crossing = 1, uncertain = 2;
     
-    if (gamma < 0 || iszero(gamma))
-        return point::bad_point();
+    size_t n = batch.size();
+    vector<double> status(n);
     
-    a = c * radians_to_degrees(sin(degrees_to_radians(alpha))) /
-    radians_to_degrees(sin(degrees_to_radians(gamma)));
+    const double* __restrict x1 = batch.x1.data();
+    const double* __restrict y1 = batch.y1.data();
+    const double* __restrict x2 = batch.x2.data();
+    const double* __restrict y2 = batch.y2.data();
+    double* __restrict s = status.data();
+    const double ax = e.p1.x, ay = e.p1.y;
+    const double bx = e.p2.x, by = e.p2.y;
+    const double err = ORIENTATION_ERROR_BOUND;
     
-    if (!iszero(a))
-        p = move_point(e2.p1, e2.p2, a);
-    else
-        p = e2.p1;
+    // the same expressions as orientation(), a and b to c -> d,
+    // c and d to a -> b; sign is certain if |det| > err * (|left| + |right|)
+    for (size_t i = 0; i < n; ++i)
+    {
+        double cx = x1[i], cy = y1[i];
+        double dx = x2[i], dy = y2[i];
+        
+        double la = (dx - cx) * (ay - cy), ra = (dy - cy) * (ax - cx);
+        double lb = (dx - cx) * (by - cy), rb = (dy - cy) * (bx - cx);
+        double lc = (bx - ax) * (cy - ay), rc = (by - ay) * (cx - ax);
+        double ld = (bx - ax) * (dy - ay), rd = (by - ay) * (dx - ax);
+        double oa = la - ra, ob = lb - rb, oc = lc - rc, od = ld - rd;
+        
+        bool ca = fabs(oa) > err * (fabs(la) + fabs(ra));
+        bool cb = fabs(ob) > err * (fabs(lb) + fabs(rb));
+        bool cc = fabs(oc) > err * (fabs(lc) + fabs(rc));
+        bool cd = fabs(od) > err * (fabs(ld) + fabs(rd));
+        
+        bool separated = (ca & cb & ((oa > 0) == (ob > 0))) |
+        (cc & cd & ((oc > 0) == (od > 0)));
+        bool certain = ca & cb & cc & cd;
+        
+        s[i] = separated ? apart : (certain ? crossing : uncertain);
+    }
     
-    if (lies_between(p, e1.p1, e1.p2) &&
-        lies_between(p, e2.p1, e2.p2))
-        return p;
-    else
-        return point::bad_point();
+    out.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (status[i] == apart)
+            out[i] = point::bad_point();
+        else if (status[i] == crossing)
+            out[i] = crossing_point(e.p1, e.p2, point(x1[i], y1[i]), point(x2[i], y2[i]));
+        else
+            out[i] = intersection(e, batch.get(i));
+    }
 }
 
 
@@ -209,3 +310,201 @@ overlap_checks::overlaps overlap_checks::get_overlaps(const overlap_checks::edge
     return vec;
     
 }
+
+
+void overlap_checks::edges_array::clear()
+{
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+}
+
+void overlap_checks::edges_array::push_back(
+                                            const edge& e)
+{
+    x1.push_back(e.p1.x);
+    y1.push_back(e.p1.y);
+    x2.push_back(e.p2.x);
+    y2.push_back(e.p2.y);
+}
+
+overlap_checks::edge overlap_checks::edges_array::get(
+                                                      size_t i) const
+{
+    return {point(x1[i], y1[i]), point(x2[i], y2[i])};
+}
+
+
+overlap_checks::edge_grid::edge_grid(
+                                     const edges& e)
+{
+    APP_DEBUG_FNAME;
+    
+    point first = e.empty() ? point(0, 0) : e[0].p1;
+    double min_x = first.x, min_y = first.y, max_x = first.x, max_y = first.y;
+    double length = 0;
+    
+    for (size_t i = 0; i < e.size(); ++i)
+    {
+        for (const point& p : {e[i].p1, e[i].p2})
+        {
+            min_x = min(min_x, p.x);
+            min_y = min(min_y, p.y);
+            max_x = max(max_x, p.x);
+            max_y = max(max_y, p.y);
+        }
+        length += distance(e[i].p1, e[i].p2);
+    }
+    
+    // cell about of edge length => edge lies in few cells
+    // and cell contains few edges
+    cell_size = e.empty() ? 1 : max(length / e.size(), 1e-3);
+    while ((max_x - min_x) / cell_size * (max_y - min_y) / cell_size >
+           GRID_MAXIMUM_CELLS_RATIO * (e.size() + 1))
+        cell_size *= 2;
+    
+    origin = point(min_x, min_y);
+    columns = (size_t)((max_x - min_x) / cell_size) + 1;
+    rows = (size_t)((max_y - min_y) / cell_size) + 1;
+    cells.resize(columns * rows);
+    reported.resize(e.size(), 0);
+    
+    for (size_t i = 0; i < e.size(); ++i)
+    {
+        cells_range r = get_range(e[i]);
+        
+        for (size_t y = r.y1; y <= r.y2; ++y)
+            for (size_t x = r.x1; x <= r.x2; ++x)
+                cells[y * columns + x].push_back(i);
+    }
+}
+
+size_t overlap_checks::edge_grid::cell_x(
+                                         double x) const
+{
+    // points out of grid (moved edges) belong to border cells
+    double c = floor((x - origin.x) / cell_size);
+    return c <= 0 ? 0 : min((size_t)c, columns - 1);
+}
+
+size_t overlap_checks::edge_grid::cell_y(
+                                         double y) const
+{
+    double c = floor((y - origin.y) / cell_size);
+    return c <= 0 ? 0 : min((size_t)c, rows - 1);
+}
+
+overlap_checks::edge_grid::cells_range overlap_checks::edge_grid::get_range(
+                                                                            const edge& e) const
+{
+    cells_range r;
+    
+    r.x1 = cell_x(min(e.p1.x, e.p2.x));
+    r.x2 = cell_x(max(e.p1.x, e.p2.x));
+    r.y1 = cell_y(min(e.p1.y, e.p2.y));
+    r.y2 = cell_y(max(e.p1.y, e.p2.y));
+    
+    return r;
+}
+
+void overlap_checks::edge_grid::move(
+                                     size_t index,
+                                     const edge& from,
+                                     const edge& to)
+{
+    cells_range r = get_range(from);
+    
+    for (size_t y = r.y1; y <= r.y2; ++y)
+        for (size_t x = r.x1; x <= r.x2; ++x)
+        {
+            vector<size_t>& cell = cells[y * columns + x];
+            cell.erase(std::find(cell.begin(), cell.end(), index));
+        }
+    
+    r = get_range(to);
+    for (size_t y = r.y1; y <= r.y2; ++y)
+        for (size_t x = r.x1; x <= r.x2; ++x)
+            cells[y * columns + x].push_back(index);
+}
+
+void overlap_checks::edge_grid::candidates(
+                                           const edge& e,
+                                           std::vector<size_t>& out) const
+{
+    cells_range r = get_range(e);
+    
+    out.clear();
+    ++query;
+    
+    for (size_t y = r.y1; y <= r.y2; ++y)
+        for (size_t x = r.x1; x <= r.x2; ++x)
+            for (size_t i : cells[y * columns + x])
+                if (reported[i] != query)
+                {
+                    reported[i] = query;
+                    out.push_back(i);
+                }
+}
+
+/* static */ size_t overlap_checks::count_overlaps(
+                                                   const edges& e,
+                                                   const edge_grid& grid,
+                                                   size_t first,
+                                                   const edges& moved)
+{
+    size_t last = first + moved.size();
+    size_t out = 0;
+    vector<size_t> candidates;
+    edges_array batch;
+    vector<point> points;
+    
+    for (size_t i = 0; i < moved.size(); ++i)
+    {
+        grid.candidates(moved[i], candidates);
+        batch.clear();
+        
+        for (size_t j : candidates)
+        {
+            // neighbours of the range share its end points
+            if (j + 1 >= first && j <= last)
+                continue;
+            if (touching_edges(moved[i], e[j]))
+                continue;
+            batch.push_back(e[j]);
+        }
+        
+        intersections(moved[i], batch, points);
+        out += count_if(points.begin(), points.end(),
+                        [](const point& p) { return !p.bad(); });
+    }
+    
+    return out;
+}
+
+/* static */ size_t overlap_checks::count_overlaps(
+                                                   const edges& e)
+{
+    edge_grid grid(e);
+    vector<size_t> candidates;
+    edges_array batch;
+    vector<point> points;
+    size_t out = 0;
+    
+    for (size_t i = 0; i < e.size(); ++i)
+    {
+        grid.candidates(e[i], candidates);
+        batch.clear();
+        
+        for (size_t j : candidates)
+            if (j > i + 1 &&
+                !touching_edges(e[i], e[j]))
+                batch.push_back(e[j]);
+        
+        intersections(e[i], batch, points);
+        out += count_if(points.begin(), points.end(),
+                        [](const point& p) { return !p.bad(); });
+    }
+    
+    return out;
+}
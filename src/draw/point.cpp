@@ -302,6 +302,180 @@ point abs(const point& p)
     return {fabs(p.x), fabs(p.y)};
 }
 
+/**
+ * exact sum/difference/product of doubles as non-overlapping pair (x + y)
+ */
+/* local */ void two_sum(double a, double b, double& x, double& y)
+{
+    x = a + b;
+    double bv = x - a;
+    double av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+/* local */ void two_diff(double a, double b, double& x, double& y)
+{
+    two_sum(a, -b, x, y);
+}
+
+/* local */ void two_product(double a, double b, double& x, double& y)
+{
+    x = a * b;
+    y = fma(a, b, -x);
+}
+
+/**
+ * exact sign of (p2 - p1) x (p3 - p1): differences and products are split
+ * to 16 exact terms which are summed to expansion (increasing magnitudes,
+ * non-overlapping), its largest non-zero component has the sign of sum
+ */
+/* local */ int orientation_exact(const point& p1, const point& p2, const point& p3)
+{
+    // (p2 - p1) x (p3 - p1) == a * b + c * d
+    double a[2], b[2], c[2], d[2];
+    double terms[16], h[16];
+    size_t n = 0, m = 0;
+    
+    two_diff(p2.x, p1.x, a[1], a[0]);
+    two_diff(p3.y, p1.y, b[1], b[0]);
+    two_diff(p1.y, p2.y, c[1], c[0]);
+    two_diff(p3.x, p1.x, d[1], d[0]);
+    
+    for (size_t i = 0; i < 2; ++i)
+        for (size_t j = 0; j < 2; ++j)
+        {
+            two_product(a[i], b[j], terms[n], terms[n + 1]);
+            two_product(c[i], d[j], terms[n + 2], terms[n + 3]);
+            n += 4;
+        }
+    
+    // grow expansion `h` by each term, zero components are eliminated
+    for (size_t i = 0; i < n; ++i)
+    {
+        double q = terms[i];
+        size_t k = 0;
+        
+        for (size_t j = 0; j < m; ++j)
+        {
+            double sum, err;
+            two_sum(q, h[j], sum, err);
+            q = sum;
+            if (err != 0)
+                h[k++] = err;
+        }
+        if (q != 0)
+            h[k++] = q;
+        m = k;
+    }
+    
+    if (m == 0)
+        return 0;
+    return h[m - 1] > 0 ? 1 : -1;
+}
+
+int orientation(const point& p1, const point& p2, const point& p3)
+{
+    BINARY(p1, p2);
+    UNARY(p3);
+    
+    double left = (p2.x - p1.x) * (p3.y - p1.y);
+    double right = (p2.y - p1.y) * (p3.x - p1.x);
+    double det = left - right;
+    
+    if (fabs(det) > ORIENTATION_ERROR_BOUND * (fabs(left) + fabs(right)))
+        return det > 0 ? 1 : -1;
+    
+    return orientation_exact(p1, p2, p3);
+}
+
+
+
+affine_transform::affine_transform()
+: a(1), b(0), c(0),
+d(0), e(1), f(0)
+{ }
+
+point affine_transform::operator()(const point& p) const
+{
+    if (p.bad())
+        return p;
+    
+    return {a * p.x + b * p.y + c, d * p.x + e * p.y + f};
+}
+
+affine_transform affine_transform::operator*(const affine_transform& other) const
+{
+    affine_transform out;
+    
+    out.a = a * other.a + b * other.d;
+    out.b = a * other.b + b * other.e;
+    out.c = a * other.c + b * other.f + c;
+    out.d = d * other.a + e * other.d;
+    out.e = d * other.b + e * other.e;
+    out.f = d * other.c + e * other.f + f;
+    
+    return out;
+}
+
+bool affine_transform::identity() const
+{
+    return a == 1 && b == 0 && c == 0 &&
+    d == 0 && e == 1 && f == 0;
+}
+
+/* static */ affine_transform affine_transform::translation(
+                                                            const point& vec)
+{
+    UNARY(vec);
+    
+    affine_transform out;
+    
+    out.c = vec.x;
+    out.f = vec.y;
+    
+    return out;
+}
+
+/* static */ affine_transform affine_transform::rotation(
+                                                         const point& centre,
+                                                         double alpha)
+{
+    UNARY(centre);
+    
+    double sin_alpha = sin(degrees_to_radians(alpha));
+    double cos_alpha = cos(degrees_to_radians(alpha));
+    affine_transform out;
+    
+    out.a = cos_alpha;
+    out.b = -sin_alpha;
+    out.d = sin_alpha;
+    out.e = cos_alpha;
+    out.c = centre.x - cos_alpha * centre.x + sin_alpha * centre.y;
+    out.f = centre.y - sin_alpha * centre.x - cos_alpha * centre.y;
+    
+    return out;
+}
+
+/* static */ affine_transform affine_transform::reflection(
+                                                           const point& p1,
+                                                           const point& p2)
+{
+    BINARY(p1, p2);
+    
+    // works for any direction of the line, vertical included
+    point u = normalize(p2 - p1);
+    affine_transform out;
+    
+    out.a = 2 * squared(u.x) - 1;
+    out.b = 2 * u.x * u.y;
+    out.d = out.b;
+    out.e = 2 * squared(u.y) - 1;
+    out.c = p1.x - out.a * p1.x - out.b * p1.y;
+    out.f = p1.y - out.d * p1.x - out.e * p1.y;
+    
+    return out;
+}
+
 
 
 bool double_equals_precision(
@@ -0,0 +1,208 @@
+/*
+ * File: radial_layout.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "radial_layout.hpp"
+
+using namespace std;
+
+// usual distances in traveler's templates
+#define DEFAULT_PAIRS_DISTANCE          8.
+#define DEFAULT_PAIR_BASE_DISTANCE      20.
+#define DEFAULT_LOOPS_BASES_DISTANCE    9.
+
+#define BISECTION_ITERATIONS            60
+// backbone next to stem is longer by RATIO * sqrt(#nodes in stem's subtree) bases
+#define RADIAL_SPREAD                   1.
+
+/**
+ * central angle of chord with `length` in circle with `radius`
+ */
+/* local */ double chord_angle(
+                               double length,
+                               double radius)
+{
+    return 2 * asin(min(1., length / (2 * radius)));
+}
+
+/**
+ * unit vector orthogonal to `p1` -> `p2`, on its right side
+ */
+/* local */ point right_side(
+                             const point& p1,
+                             const point& p2)
+{
+    point v = normalize(p2 - p1);
+    return point(v.y, -v.x);
+}
+
+
+radial_layout::radial_layout(
+                             rna_tree& _rna)
+: rna(_rna),
+pairs_distance(DEFAULT_PAIRS_DISTANCE),
+pair_base_distance(DEFAULT_PAIR_BASE_DISTANCE),
+loops_bases_distance(DEFAULT_LOOPS_BASES_DISTANCE)
+{ }
+
+radial_layout::radial_layout(
+                             rna_tree& _rna,
+                             const rna_tree& templated)
+: radial_layout(_rna)
+{
+    // bad distances (no points in template) stay default
+    for (auto d : {
+        make_pair(&pairs_distance, templated.get_pairs_distance()),
+        make_pair(&pair_base_distance, templated.get_pair_base_distance()),
+        make_pair(&loops_bases_distance, templated.get_loops_bases_distance())})
+    {
+        if (d.second > 0 && d.second < 0xBADF00D)
+            *d.first = d.second;
+    }
+}
+
+void radial_layout::run()
+{
+    APP_DEBUG_FNAME;
+    
+    INFO("BEG: Computing radial layout for RNA %s", rna.name());
+    
+    subtree_sizes.assign(rna.size(), 1);
+    for (post_order_iterator it = rna.begin_post(); it != rna.end_post(); ++it)
+        if (!rna_tree::is_root(it))
+            subtree_sizes.at(id(rna_tree::parent(it))) += subtree_sizes.at(id(it));
+    
+    // exterior loop is closed by virtual pair of 5' and 3' ends
+    lay_out_loop(rna.begin(), point(0, 0), point(loops_bases_distance, 0));
+    
+    // parents are visited before children, so bases of every pair are placed
+    for (iterator it = ++rna.begin(); it != rna.end(); ++it)
+    {
+        if (!it->paired() || rna_tree::is_leaf(it))
+            continue;
+        
+        point p1 = it->at(0).p, p2 = it->at(1).p;
+        sibling_iterator ch = it.begin();
+        
+        if (rna_tree::is_only_child(ch) && ch->paired())
+        {
+            // stacked pair continues the stem
+            point dir = right_side(p1, p2) * pairs_distance;
+            ch->at(0).p = p1 + dir;
+            ch->at(1).p = p2 + dir;
+        }
+        else
+            lay_out_loop(it, p1, p2);
+    }
+    
+    update_ends_in_rna(rna);
+    rna.invalidate_flat();
+    
+    INFO("END: Computing radial layout");
+}
+
+void radial_layout::lay_out_loop(
+                                 iterator parent,
+                                 point p1,
+                                 point p2)
+{
+    if (rna_tree::is_leaf(parent))
+        return;
+    
+    double closing = distance(p1, p2);
+    // chords of circle from p1 to p2: backbone in front of every child,
+    // pairs of children and backbone behind the last child;
+    // backbone next to stem is longer to make room for its subtree
+    vector<double> chords;
+    double spread = 0;
+    
+    for (sibling_iterator ch = parent.begin(); ch != parent.end(); ++ch)
+    {
+        double width = ch->paired() ? RADIAL_SPREAD * loops_bases_distance * sqrt(subtree_sizes.at(id(ch))) : 0;
+        
+        chords.push_back(loops_bases_distance + spread + width);
+        if (ch->paired())
+            chords.push_back(pair_base_distance);
+        spread = width;
+    }
+    chords.push_back(loops_bases_distance + spread);
+    
+    // loop is closed when its chords make full circle,
+    // sum of their angles decreases with radius
+    auto full_angle = [&](double radius)
+    {
+        double out = chord_angle(closing, radius);
+        for (double c : chords)
+            out += chord_angle(c, radius);
+        return out;
+    };
+    
+    double low = max(closing, *max_element(chords.begin(), chords.end())) / 2;
+    double high = low;
+    double scale = 1;
+    
+    if (full_angle(low) < 2 * M_PI)
+    {
+        // even half circle is too short (tiny loop), angles are stretched
+        scale = 2 * M_PI / full_angle(low);
+    }
+    else
+    {
+        while (full_angle(high) > 2 * M_PI)
+            high *= 2;
+        for (size_t i = 0; i < BISECTION_ITERATIONS; ++i)
+        {
+            double middle = (low + high) / 2;
+            (full_angle(middle) > 2 * M_PI ? low : high) = middle;
+        }
+    }
+    
+    // angles of chords are measured on circle with `high` radius
+    // and stretched, so they sum up to full circle with alpha
+    double alpha = scale * chord_angle(closing, high);
+    
+    // circle goes through p1, p2, its centre is on loop side
+    double radius = closing / (2 * sin(alpha / 2));
+    point c = center(p1, p2) + right_side(p1, p2) * (radius * cos(alpha / 2));
+    
+    // walking from p1 to p2 around the loop, the closing chord is the last step;
+    // direction is chosen so that it ends in p2
+    double start = atan2(p1.y - c.y, p1.x - c.x);
+    double end = atan2(p2.y - c.y, p2.x - c.x);
+    double sign = cos(start - (2 * M_PI - alpha) - end) > cos(start + (2 * M_PI - alpha) - end) ? -1 : 1;
+    double angle = start;
+    
+    auto next = [&](double length)
+    {
+        angle += sign * scale * chord_angle(length, high);
+        return point(c.x + radius * cos(angle), c.y + radius * sin(angle));
+    };
+    
+    auto chord = chords.begin();
+    for (sibling_iterator ch = parent.begin(); ch != parent.end(); ++ch)
+    {
+        ch->at(0).p = next(*chord++);
+        if (ch->paired())
+            ch->at(1).p = next(*chord++);
+    }
+}
@@ -22,10 +22,15 @@
 #ifndef APP_HPP
 #define APP_HPP
 
+#include <memory>
+
 #include "types.hpp"
 
 class rna_tree;
+typedef std::shared_ptr<const rna_tree> rna_tree_ptr;
 class mapping;
+class prepared_template;
+struct shard;
 
 /**
  * class to handle flow
@@ -55,27 +60,110 @@ private:
      * run with handled command line arguments
      */
     void run(
-             arguments args);
+             const arguments& args);
     
     /**
      * run tree-edit-distance algorithm
      * returns mapping between templated and matched tree
      */
     mapping run_ted(
-                    rna_tree& templated,
-                    rna_tree& matched,
+                    const rna_tree_ptr& templated,
+                    const rna_tree_ptr& matched,
                     bool save,
-                    const std::string& mapping_file);
+                    const std::string& mapping_file,
+                    const std::string& cache_dir);
+    
+    /**
+     * run tree-edit-distance algorithm, results are looked up in / stored to
+     * on-disk cache in `cache_dir`
+     */
+    mapping run_ted_cached(
+                           const prepared_template& templ,
+                           const rna_tree_ptr& matched,
+                           const std::string& cache_dir);
+    
+    /**
+     * choose best template from library in `directory` for `matched`,
+     * chosen template is stored to `templated`;
+     * if `index_file` is set, vp_tree index is used (and created if needed);
+     * returns mapping between templated and matched tree
+     */
+    mapping run_template_library(
+                                 rna_tree_ptr& templated,
+                                 const rna_tree_ptr& matched,
+                                 const std::string& directory,
+                                 size_t top,
+                                 const std::string& index_file,
+                                 const std::string& mapping_file);
+    
+    /**
+     * for every target (fasta file) in `part` of `list_file` choose best template
+     * from library in `directory` and draw target to `out_dir`;
+     * chosen templates are listed in layout manifest `out_dir`/manifest.tsv
+     */
+    void run_template_library_batch(
+                                    const std::string& directory,
+                                    size_t top,
+                                    const std::string& index_file,
+                                    const std::string& list_file,
+                                    const std::string& out_dir,
+                                    bool overlaps,
+                                    size_t refine_iterations,
+                                    const shard& part);
+    
+    /**
+     * compute tree-edit-distances between all structures (fasta files)
+     * listed in `list_file` and save them to `file`;
+     * mappings are saved to `mapping_dir`, if it is set;
+     * only pairs in `part` are computed and saved as partial output
+     */
+    void run_distance_matrix(
+                             const std::string& list_file,
+                             const std::string& file,
+                             size_t threads,
+                             const std::string& mapping_dir,
+                             const shard& part);
     
     /**
-     * run drawing algorithm, visualized molecule will be saved
+     * merge partial outputs of `count` shards (distance matrix
+     * or layout manifest) to `file`
+     */
+    void run_merge_shards(
+                          const std::string& file,
+                          size_t count);
+    
+    /**
+     * run drawing algorithm, visualized molecule will be saved;
+     * shared `templated` is not changed, matcher works on its copy;
+     * if `refine_iterations` is set, layout is refined by force_refine
      */
     void run_drawing(
-                     rna_tree& templated,
-                     rna_tree& matched,
+                     const rna_tree_ptr& templated,
+                     const rna_tree_ptr& matched,
                      const mapping& mapping,
                      bool run,
                      bool run_overlaps,
+                     size_t refine_iterations,
+                     const std::string& file);
+    
+    /**
+     * draw `matched` by radial_layout (no template and mapping are needed),
+     * distances between bases are taken from `templated` if it is set
+     */
+    void run_radial(
+                    const rna_tree_ptr& templated,
+                    const rna_tree_ptr& matched,
+                    bool run_overlaps,
+                    const std::string& file);
+    
+    /**
+     * lay out `matched` by `templated` and then read next versions of target
+     * from standard input, each of them is laid out incrementally by layout_session
+     */
+    void run_session(
+                     const rna_tree_ptr& templated,
+                     const rna_tree_ptr& matched,
+                     bool run_overlaps,
                      const std::string& file);
     
     /**
@@ -90,18 +178,26 @@ private:
     /**
      * reads both seq & fold file and construct rna tree
      */
-    static rna_tree create_matched(
+    static rna_tree_ptr create_matched(
                                    const std::string& fastafile);
     
     /**
      * reads ps & fold file and construct rna tree
      * from ps extract rna sequence and node positions in image
      */
-    static rna_tree create_templated(
+    static rna_tree_ptr create_templated(
                                      const std::string& templatefile,
                                      const std::string& templatetype,
                                      const std::string& fastafile);
     
+    /**
+     * reads list of fasta files from `list_file`, paths are relative to list file;
+     * structures are named by their file names
+     */
+    static std::vector<std::string> read_list(
+                                              const std::string& list_file,
+                                              std::vector<std::string>& names);
+    
     /**
      * print arguments
      */
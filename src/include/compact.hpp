@@ -22,6 +22,9 @@
 #ifndef COMPACT_HPP
 #define COMPACT_HPP
 
+#include <functional>
+#include <mutex>
+
 #include "rna_tree.hpp"
 
 class compact
@@ -40,10 +43,27 @@ public:
     typedef rna_tree::sibling_iterator          sibling_iterator;
     typedef std::vector<point>                  points_vec;
     typedef std::vector<sibling_iterator>       nodes_vec;
+    typedef std::vector<iterator>               iterators_vec;
     
 public:
+    /**
+     * edited nodes (inserted or with remake_ids) are found by full scan of `_rna`
+     */
     compact(
-            rna_tree& _rna);
+            rna_tree& _rna,
+            size_t _threads = 1);
+    
+    /**
+     * only nodes from `_edited` and loops around them will be laid out,
+     * `_edited` have to be in preorder, see matcher::get_edited();
+     * stems are still straightened and inserted branches checked
+     * against the whole molecule
+     * independent subtrees are laid out on up to `_threads` threads
+     */
+    compact(
+            rna_tree& _rna,
+            const iterators_vec& _edited,
+            size_t _threads = 1);
     
     /**
      * run compact algorithm.
@@ -56,36 +76,36 @@ private:
     /**
      * sets distance between `parent` and `child`
      */
-    static void set_distance(
-                             iterator parent,
-                             iterator child,
-                             double distance);
+    void set_distance(
+                      iterator parent,
+                      iterator child,
+                      double distance);
     
-    static void set_distance(
-                             iterator it,
-                             point from,
-                             double distance);
+    void set_distance(
+                      iterator it,
+                      point from,
+                      double distance);
     
     /**
      * shift full subtree rooted at `parent` with vector `vec`
      */
-    static void shift_branch(
-                             iterator parent,
-                             point vec);
+    void shift_branch(
+                      iterator parent,
+                      point vec);
     
     /**
      * mirrors full subtree rooted at `root` using the root's bp as the mirror line
      */
-    static void mirror_branch(
-                              iterator root);
+    void mirror_branch(
+                       iterator root);
     
     /**
      * rotate branch from `parent` arount circle `c` with angle `alpha`
      */
-    static void rotate_branch(
-                              iterator parent,
-                              circle c,
-                              double alpha);
+    void rotate_branch(
+                       iterator parent,
+                       circle c,
+                       double alpha);
     
     /**
      * returns if child number `n` should be remade
@@ -114,7 +134,8 @@ private:
     void init();
     
     /**
-     * make all branches lie on straight line
+     * make all branches lie on straight line,
+     * also the ones not touched by edits (template stems are not exactly even)
      */
     void init_even_branches();
     
@@ -229,7 +250,58 @@ private:
      */
     inline void checks();
     
-    void try_reposition_new_root_branches();
+    /**
+     * mirrors or rotates inserted branches (at any depth) when it lowers
+     * the number of their intersections with the rest of the molecule;
+     * only edges of the branch are checked, using overlap_checks::edge_grid
+     * of the whole backbone, which is built only if some branch was inserted
+     */
+    void reposition_inserted_branches();
+    
+    /**
+     * runs `f` for all `roots`, in parallel when their subtrees are large enough;
+     * subtrees of `roots` have to be disjoint and their ancestors
+     * must not have pending transforms
+     */
+    void for_each_subtree(
+                          const iterators_vec& roots,
+                          const std::function<void(iterator)>& f);
+    
+private:
+    // pending transforms:
+    /**
+     * moves full subtree rooted at `it` with `t`;
+     * for inner nodes `t` is only stored and applied later
+     * (see apply_pending), so the same subtree can be shifted, rotated
+     * or mirrored many times for the price of one pass
+     */
+    void transform_branch(
+                          iterator it,
+                          const affine_transform& t);
+    
+    /**
+     * applies transform pending in `it` to its points
+     * and passes it to its children
+     * .. all ancestors of `it` must not have any pending transforms
+     */
+    void push(
+              iterator it);
+    
+    /**
+     * push all transforms pending in `it` and its ancestors;
+     * afterwards points of `it`, its ancestors and leaf children are valid
+     * !!! must be called before reading or writing points in subtree
+     *  touched by transform_branch !!!
+     */
+    void apply_pending(
+                       iterator it);
+    
+    /**
+     * push all pending transforms down to points,
+     * only subtrees which have some transform pending are visited
+     */
+    void apply_all_pending();
+    // pending transforms ^^
     
     
 private:
@@ -240,6 +312,24 @@ private:
     
 private:
     rna_tree &  rna;
+    /**
+     * transforms waiting to be applied on subtrees, indexed by node id
+     */
+    std::vector<affine_transform> pending;
+    /**
+     * nodes which got pending transform
+     */
+    iterators_vec tagged;
+    std::mutex tagged_mutex;
+    /**
+     * worklist: nodes edited by matcher in preorder
+     */
+    iterators_vec edited;
+    /**
+     * parents which have to be remade because init() moved their children
+     */
+    iterators_vec remade;
+    size_t threads;
 };
 
 #endif /* !COMPACT_HPP */
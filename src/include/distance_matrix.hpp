@@ -0,0 +1,104 @@
+/*
+ * File: distance_matrix.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef DISTANCE_MATRIX_HPP
+#define DISTANCE_MATRIX_HPP
+
+#include "rna_tree.hpp"
+#include "shard.hpp"
+
+class mapping;
+
+/**
+ * all-vs-all tree-edit-distances between rna structures
+ *
+ * every unordered pair is computed once (costs are symmetric),
+ * mapping in opposite direction is obtained by mapping::reverse();
+ * pairs are processed by pool of threads, template-side data
+ * of every rna are prepared only once;
+ * pairs can be split to shards computed separately and merged later
+ */
+class distance_matrix
+{
+public:
+    typedef std::vector<std::vector<size_t>>    matrix_type;
+    /**
+     * called for each computed mapping `i` -> `j`, from more threads
+     */
+    typedef std::function<void(size_t, size_t, const mapping&)> mapping_function;
+    
+public:
+    distance_matrix(
+                    const std::vector<rna_tree_ptr>& rnas,
+                    const std::vector<std::string>& names);
+    /**
+     * rnas are copied to shared trees
+     */
+    distance_matrix(
+                    const std::vector<rna_tree>& rnas,
+                    const std::vector<std::string>& names);
+    
+    /**
+     * compute distances of pairs in `part` using `threads` threads
+     */
+    void run(
+             size_t threads,
+             mapping_function on_mapping = nullptr,
+             const shard& part = shard());
+    
+    const matrix_type& get_distances() const
+    {
+        return distances;
+    }
+    
+    /**
+     * save matrix as tab-separated values, first row and column contain names
+     */
+    void save(
+              const std::string& filename) const;
+    
+    /**
+     * save distances computed by last run as partial output of its shard
+     */
+    void save_partial(
+                      const std::string& filename) const;
+    
+    /**
+     * merge partial outputs of all `count` shards of `filename`,
+     * every pair has to be computed by exactly one shard
+     */
+    static distance_matrix merge(
+                                 const std::string& filename,
+                                 size_t count);
+    
+private:
+    distance_matrix() = default;
+    
+private:
+    std::vector<rna_tree_ptr> rnas;
+    std::vector<std::string> names;
+    matrix_type distances;
+    shard part;
+    std::vector<std::pair<size_t, size_t>> computed;
+};
+
+#endif /* !DISTANCE_MATRIX_HPP */
@@ -91,7 +91,7 @@ public:
                                              rna_tree::pre_post_order_iterator begin,
                                              rna_tree::pre_post_order_iterator end) const;
     std::string get_rna_formatted(
-                                  rna_tree rna) const;
+                                  rna_tree& rna) const;
     std::string get_rna_subtree_formatted(
                                           rna_tree::iterator root) const;
     
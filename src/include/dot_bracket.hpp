@@ -0,0 +1,93 @@
+/*
+ * File: dot_bracket.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef DOT_BRACKET_HPP
+#define DOT_BRACKET_HPP
+
+#include <cstdint>
+
+#include "types.hpp"
+
+/**
+ * dot-bracket structure parsed in one pass
+ *
+ * characters are classified by lookup table, pairs are found by stack of
+ * opened brackets; pseudoknot brackets are read as unpaired bases;
+ * whitespaces are allowed only around structure
+ */
+struct dot_bracket
+{
+    enum char_class : uint8_t
+    {
+        invalid,
+        whitespace,
+        unpaired,
+        opening,
+        closing,
+    };
+    
+    static const size_t NONE = SIZE_MAX;
+    
+    /**
+     * parse `brackets`,
+     * throws wrong_argument_exception on invalid character or unbalanced brackets
+     */
+    static dot_bracket parse(
+                             const std::string& brackets);
+    
+    /**
+     * returns class of `ch`
+     */
+    static char_class get_class(
+                                char ch);
+    
+    /**
+     * returns if `line` contains some dot-bracket character (dot, bracket)
+     */
+    static bool is_structure_line(
+                                  const std::string& line);
+    
+    size_t size() const
+    {
+        return pairs.size();
+    }
+    
+    bool is_opening(
+                    size_t i) const
+    {
+        return pairs[i] != NONE && pairs[i] > i;
+    }
+    
+    bool is_closing(
+                    size_t i) const
+    {
+        return pairs[i] != NONE && pairs[i] < i;
+    }
+    
+    /**
+     * index of paired base of every base, NONE for unpaired bases;
+     * indexes are counted without leading whitespaces
+     */
+    std::vector<size_t> pairs;
+};
+
+#endif /* !DOT_BRACKET_HPP */
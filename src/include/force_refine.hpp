@@ -0,0 +1,96 @@
+/*
+ * File: force_refine.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef FORCE_REFINE_HPP
+#define FORCE_REFINE_HPP
+
+#include "rna_tree.hpp"
+
+/**
+ * force-directed relaxation of layout made by compact;
+ * only bases of inserted, reinserted or rotated nodes are moved,
+ * other bases are pinned
+ *  - springs keep distances of backbone neighbours, base pairs
+ *      and bases two steps apart from the initial layout
+ *  - bases closer than usual distance repel each other,
+ *      neighbours are found exactly in a uniform grid
+ *  - movable ends of crossing backbone edges are pushed
+ *      beyond the other edge
+ */
+class force_refine
+{
+    struct grid;
+    struct spring
+    {
+        size_t from, to;
+        double length;
+        double strength;
+    };
+    
+public:
+    typedef std::vector<point> points_vec;
+    
+public:
+    force_refine(
+                 rna_tree& _rna,
+                 size_t _iterations);
+    
+    /**
+     * relax layout for at most `iterations` steps (or until time budget is exceeded);
+     * refined layout is kept only when it does not have more overlaps
+     */
+    void run();
+    
+private:
+    /**
+     * one step of relaxation, `temperature` limits shift of each base
+     */
+    void step(
+              double temperature);
+    
+    /**
+     * adds forces untangling crossings of backbone edges
+     * with at least one movable end
+     */
+    void add_crossing_forces(
+                             points_vec& forces) const;
+    
+    /**
+     * number of intersections of backbone in `p`
+     */
+    static size_t count_overlaps(
+                                 const points_vec& p);
+    
+private:
+    rna_tree& rna;
+    size_t iterations;
+    
+    /**
+     * all bases of rna (without 5'/3' ends) in the backbone order
+     */
+    points_vec points;
+    std::vector<rna_label*> labels;
+    std::vector<bool> movable;
+    std::vector<spring> springs;
+    double radius;
+};
+
+#endif /* !FORCE_REFINE_HPP */
@@ -22,6 +22,9 @@
 #ifndef GTED_HPP
 #define GTED_HPP
 
+#include <memory>
+#include <random>
+
 #include "strategy.hpp"
 #include "gted_tree.hpp"
 
@@ -38,6 +41,7 @@ public:
     rev_post_order_iterator;
     typedef std::vector<std::vector<size_t>>            tree_distance_table_type;
     typedef std::vector<std::vector<size_t>>            forest_distance_table_type;
+    typedef std::shared_ptr<tree_type>                  tree_ptr;
     
     /**
      * instead of using constants, use this functions
@@ -48,12 +52,23 @@ public:
         static size_t del(iterator it);
         static size_t ins(iterator it);
         static size_t upd(iterator it1, iterator it2);
+        
+        /**
+         * returns text describing actual cost model
+         */
+        static std::string description();
     };
     
 public:
     gted(
          const rna_tree& _t1,
          const rna_tree& _t2);
+    /**
+     * use already initialized gted_tree `_t1`
+     */
+    gted(
+         const tree_ptr& _t1,
+         const rna_tree& _t2);
     
     /**
      * run gted
@@ -66,6 +81,11 @@ public:
      */
     mapping get_mapping();
     
+    /**
+     * returns tree-edit-distance computed by run()
+     */
+    size_t get_distance() const;
+    
 private:
     /**
      * recursive compute distances between subtrees root1/root2
@@ -95,8 +115,8 @@ private:
     std::vector<std::vector<size_t>> compute_distance_LR(
                                                          iterator root1,
                                                          iterator root2,
-                                                         tree_type& t1,
-                                                         tree_type& t2,
+                                                         const tree_type& t1,
+                                                         const tree_type& t2,
                                                          funct_get_begin get_begin);
     
 private: // functions allowing some checks..
@@ -127,10 +147,16 @@ private: // functions allowing some checks..
     inline void check_ids_postorder();
     
 private:
-    tree_type t1, t2;
+    tree_ptr t1_ptr, t2_ptr;
+    tree_type &t1, &t2;
     strategy_table_type STR;
     strategy actual_str;
     tree_distance_table_type tdist;
+    /**
+     * chooses decomposition instead of heavy one,
+     * owned by instance so gted runs are reproducible and can run in parallel
+     */
+    std::minstd_rand random;
 };
 
 #endif /* !GTED_HPP */
@@ -0,0 +1,158 @@
+/*
+ * File: layout_session.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef LAYOUT_SESSION_HPP
+#define LAYOUT_SESSION_HPP
+
+#include "prepared_template.hpp"
+#include "mapping.hpp"
+
+/**
+ * persistent layout of one template and an edited target:
+ * template is prepared once, target is laid out by layout() and then
+ * changed by update(); only the smallest matched pair enclosing the change
+ * is matched again by TED and only loops in its subtree are laid out
+ * again by compact, other bases keep their positions
+ */
+class layout_session
+{
+public:
+    typedef rna_tree::iterator iterator;
+    
+    /**
+     * target bases [begin, end) are replaced by `brackets` and `labels`
+     */
+    struct delta
+    {
+        size_t begin;
+        size_t end;
+        std::string brackets;
+        std::string labels;
+    };
+    
+public:
+    layout_session(
+                   const rna_tree_ptr& templated,
+                   size_t _threads = 1);
+    
+    /**
+     * match and lay out `matched` from scratch
+     */
+    const rna_tree& layout(
+                           const rna_tree_ptr& matched);
+    
+    /**
+     * apply `d` to the target and update the layout,
+     * full layout is made when no matched pair encloses the change
+     */
+    const rna_tree& update(
+                           const delta& d);
+    
+    /**
+     * update the layout to target `brackets` and `labels`,
+     * see diff()
+     */
+    const rna_tree& update(
+                           const std::string& brackets,
+                           const std::string& labels);
+    
+    /**
+     * returns the smallest delta changing target `brackets`/`labels`
+     * to `new_brackets`/`new_labels` (common prefix and suffix are kept)
+     */
+    static delta diff(
+                      const std::string& brackets,
+                      const std::string& labels,
+                      const std::string& new_brackets,
+                      const std::string& new_labels);
+    
+    const rna_tree& get_rna() const
+    {
+        return rna;
+    }
+    const mapping& get_mapping() const
+    {
+        return map;
+    }
+    
+private:
+    /**
+     * changed part of target: subtree of the smallest matched pair enclosing
+     * the change, nodes are given by 1-based postorder ids
+     */
+    struct region
+    {
+        // bases [begin, end] of the pair in new target
+        size_t begin, end;
+        size_t templ_id, templ_size;
+        size_t old_id, old_size;
+        size_t new_id, new_size;
+    };
+    
+private:
+    /**
+     * merge mapping of old target out of `r` with mapping between
+     * template subtree and new target subtree made by TED;
+     * returns false if old mapping does not map `r` into template subtree
+     */
+    bool rematch(
+                 const std::string& new_brackets,
+                 const std::string& new_labels,
+                 region& r,
+                 mapping& out) const;
+    
+    /**
+     * lay out `target` with mapping `m`; if `r` is set, only loops in `r`
+     * are laid out again and other nodes keep positions of the current layout
+     */
+    void draw(
+              const rna_tree& target,
+              const mapping& m,
+              const region* r);
+    
+    /**
+     * returns transform placing template subtree of `r` onto old layout of `r`
+     */
+    affine_transform fit(
+                         const region& r,
+                         const std::vector<iterator>& old_nodes) const;
+    
+private:
+    prepared_template templ;
+    size_t threads;
+    
+    std::string brackets;
+    std::string labels;
+    std::string name;
+    /**
+     * copy of the template, shared trees give only const iterators
+     * and subtrees of template are extracted through `templ_nodes`
+     */
+    rna_tree templ_rna;
+    /**
+     * nodes of `templ_rna` indexed by node id
+     */
+    std::vector<iterator> templ_nodes;
+    mapping map;
+    rna_tree rna;
+};
+
+#endif /* !LAYOUT_SESSION_HPP */
@@ -22,7 +22,9 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <atomic>
 #include <cstdarg>
+#include <mutex>
 #include <vector>
 #include <sstream>
 
@@ -71,6 +73,11 @@ public:
         EMERG   = 5,
     };
     
+    /**
+     * thread does not override priority of logger
+     */
+    static const int NO_THREAD_PRIORITY = -1;
+    
     /**
      * stream object for logging
      */
@@ -113,20 +120,36 @@ public:
     
 public:
     /**
-     * returns priority for this logger
+     * returns priority for this logger in current thread
      */
     inline priority get_priority() const
     {
-        return p;
+        return thread_p != NO_THREAD_PRIORITY ? priority(thread_p) : p.load();
     }
     
     /**
-     * sets priority for this logger
+     * sets priority for this logger,
+     * if current thread overrides priority, only its override is changed
      */
     inline void set_priority(
                              priority other)
     {
-        p = other;
+        if (thread_p != NO_THREAD_PRIORITY)
+            thread_p = other;
+        else
+            p = other;
+    }
+    
+    /**
+     * overrides priority in current thread only,
+     * returns previous override (or NO_THREAD_PRIORITY)
+     */
+    inline int set_thread_priority(
+                                   int other)
+    {
+        int old = thread_p;
+        thread_p = other;
+        return old;
     }
     
 protected:
@@ -164,7 +187,7 @@ protected:
     inline bool can_log(
                         priority other) const
     {
-        return other >= p;
+        return other >= get_priority();
     }
     
 public:
@@ -182,8 +205,13 @@ public:
     std::vector<int> opened_files() const;
     
 protected:
-    priority p;
+    std::atomic<priority> p;
+    static thread_local int thread_p;
     std::vector<FILE*> out;
+    /**
+     * messages from more threads are not interleaved
+     */
+    std::mutex out_mutex;
     
 #undef LOGGER_PRIORITY_FUNCTION_BODY
 #undef LOGGER_PRIORITY_FUNCTION
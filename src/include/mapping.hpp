@@ -54,6 +54,12 @@ public:
      */
     indexes get_to_remove() const;
     
+    /**
+     * returns mapping in opposite direction (t2 -> t1),
+     * valid because insert and delete costs are same
+     */
+    mapping reverse() const;
+    
 public:
     size_t distance;
     std::vector<mapping_pair> map;
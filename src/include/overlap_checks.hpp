@@ -42,6 +42,76 @@ public:
     typedef std::vector<edge> edges;
     typedef std::vector<overlapping> overlaps;
     
+    /**
+     * edges stored as parallel arrays of end points coordinates,
+     * candidates of one edge are gathered here for intersections()
+     */
+    class edges_array
+    {
+    public:
+        inline size_t size() const;
+        void clear();
+        void push_back(
+                       const edge& e);
+        edge get(
+                 size_t i) const;
+        
+    private:
+        std::vector<double> x1, y1, x2, y2;
+        
+        friend class overlap_checks;
+    };
+    
+    /**
+     * uniform grid over bounding boxes of edges;
+     * edges which intersect each other share at least one cell
+     */
+    class edge_grid
+    {
+    public:
+        edge_grid(
+                  const edges& e);
+        
+        /**
+         * move edge number `index` from position `from` to `to`
+         */
+        void move(
+                  size_t index,
+                  const edge& from,
+                  const edge& to);
+        
+        /**
+         * stores to `out` indexes of edges sharing any cell with `e`,
+         * each index only once
+         */
+        void candidates(
+                        const edge& e,
+                        std::vector<size_t>& out) const;
+        
+    private:
+        struct cells_range
+        {
+            size_t x1, y1, x2, y2;
+        };
+        
+        size_t cell_x(
+                      double x) const;
+        size_t cell_y(
+                      double y) const;
+        cells_range get_range(
+                              const edge& e) const;
+        
+    private:
+        point origin;
+        double cell_size;
+        size_t columns, rows;
+        std::vector<std::vector<size_t>> cells;
+        
+        // last query which reported edge, to not report it twice
+        mutable std::vector<size_t> reported;
+        mutable size_t query = 0;
+    };
+    
 public:
     overlap_checks();
     
@@ -54,6 +124,34 @@ public:
     static edges get_edges(const rna_tree::iterator& node);
     static overlaps get_overlaps(const edges &e1, const edges &e2);
     
+    /**
+     * counts intersections of `moved` edges, which replace edges
+     * [first, first + moved.size()) of `e`, with other edges of `e`;
+     * intersections inside of replaced range are not counted
+     * `grid` has to index `e` (replaced edges can be stale)
+     */
+    static size_t count_overlaps(
+                                 const edges& e,
+                                 const edge_grid& grid,
+                                 size_t first,
+                                 const edges& moved);
+    
+    /**
+     * counts intersections of all non-neighbouring edges of `e`
+     */
+    static size_t count_overlaps(
+                                 const edges& e);
+    
+    /**
+     * out[i] = intersection(e, batch.get(i)); orientations of all edges
+     * are computed at once by branch-free (vectorized) loop, only edges
+     * with uncertain sign or crossing `e` are then handled one by one
+     */
+    static void intersections(
+                              const edge& e,
+                              const edges_array& batch,
+                              std::vector<point>& out);
+    
 private:
     /**
      * create edges of rna
@@ -66,18 +164,22 @@ private:
     edges get_edges(
                     rna_tree& rna);
     
+#ifdef TESTS
+public:
+#endif
     /**
-     * run checks for edges
+     * run checks for edges, only edges sharing a cell of edge_grid are tested;
+     * overlaps are the same (and in the same order) as of testing all pairs
      */
     overlaps run(
                  const edges& e);
     
-#ifdef TESTS
-public:
-#endif
     /**
      * find point in which edges are intersecting each other
      * if no point exist, return point::bad_point
+     * edges intersect if they cross or an end point of one edge lies inside
+     * of the other one; edges sharing an end point and collinear edges
+     * do not intersect; tests are exact (see orientation())
      */
     static point intersection(
                               const edge& e1,
@@ -85,4 +187,9 @@ public:
     
 };
 
+inline size_t overlap_checks::edges_array::size() const
+{
+    return x1.size();
+}
+
 #endif /* !OVERLAP_CHECKS_HPP */
@@ -92,6 +92,64 @@ bool lies_between(point p, point from, point to);
 
 point abs(const point& p);
 
+/**
+ * relative error bound of floating-point (p2 - p1) x (p3 - p1),
+ * if |det| is larger, sign of det is exact (Shewchuk's orient2d filter)
+ */
+#define ORIENTATION_ERROR_BOUND 3.3306690738754716e-16
+
+/**
+ * exact sign of cross product (p2 - p1) x (p3 - p1):
+ * 1 if p3 lies left of p1 -> p2, -1 if right, 0 if points are collinear;
+ * floating-point value is used when it is certain, otherwise exact arithmetic
+ */
+int orientation(const point& p1, const point& p2, const point& p3);
+
+
+/**
+ * affine map of the plane:
+ *  (x, y) -> (a * x + b * y + c, d * x + e * y + f)
+ * bad points are left bad
+ */
+struct affine_transform
+{
+    double a, b, c;
+    double d, e, f;
+    
+public:
+    /**
+     * identity transform
+     */
+    affine_transform();
+    
+    point operator()(const point& p) const;
+    
+    /**
+     * returns transform which applies `other` first and then `this`
+     */
+    affine_transform operator*(const affine_transform& other) const;
+    
+    bool identity() const;
+    
+public:
+    static affine_transform translation(
+                                        const point& vec);
+    
+    /**
+     * rotation by `alpha` degrees around `centre`
+     */
+    static affine_transform rotation(
+                                     const point& centre,
+                                     double alpha);
+    
+    /**
+     * reflection across the line going through `p1` and `p2`
+     */
+    static affine_transform reflection(
+                                       const point& p1,
+                                       const point& p2);
+};
+
 
 // functions for double comparing
 
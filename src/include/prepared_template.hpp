@@ -0,0 +1,90 @@
+/*
+ * File: prepared_template.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef PREPARED_TEMPLATE_HPP
+#define PREPARED_TEMPLATE_HPP
+
+#include "rted.hpp"
+#include "gted.hpp"
+
+/**
+ * template rna with all template-side data precomputed,
+ * so one template can be matched against many targets:
+ *  rted tables (subtree sizes, relevant subforests, full decomposition)
+ *  gted_tree (keyroots, subforests, leafs)
+ * layout statistics (distances between bases) are computed once by rna_tree
+ * of template and are copied by matcher to the tree laid out by compact
+ */
+class prepared_template
+{
+public:
+    /**
+     * template shares `templated`
+     */
+    prepared_template(
+                      const rna_tree_ptr& templated);
+    /**
+     * template copies `templated`
+     */
+    prepared_template(
+                      const rna_tree& templated);
+    
+    /**
+     * returns template rna
+     */
+    const rna_tree& get_rna() const
+    {
+        return *rna;
+    }
+    
+public:
+    /**
+     * returns rted between template and `matched`,
+     * only tables of `matched` are computed in rted::run()
+     */
+    rted get_rted(
+                  const rna_tree_ptr& matched) const;
+    rted get_rted(
+                  const rna_tree& matched) const;
+    
+    /**
+     * returns gted between template and `matched`,
+     * only gted_tree of `matched` is computed
+     */
+    gted get_gted(
+                  const rna_tree& matched) const;
+    
+    /**
+     * run rted and gted between template and `matched`, returns mapping
+     */
+    mapping run_ted(
+                    const rna_tree_ptr& matched) const;
+    mapping run_ted(
+                    const rna_tree& matched) const;
+    
+private:
+    rna_tree_ptr rna;
+    rted::tree_tables_ptr rted_tables;
+    gted::tree_ptr gted_tree_ptr;
+};
+
+#endif /* !PREPARED_TEMPLATE_HPP */
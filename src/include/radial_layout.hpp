@@ -0,0 +1,80 @@
+/*
+ * File: radial_layout.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef RADIAL_LAYOUT_HPP
+#define RADIAL_LAYOUT_HPP
+
+#include "rna_tree.hpp"
+
+/**
+ * template-free layout in linear time:
+ * stems are straight ladders, every loop (also the exterior one)
+ * lies on a circle going through bases of its closing pair;
+ * used when no template is good enough or TED would be too expensive
+ */
+class radial_layout
+{
+public:
+    typedef rna_tree::iterator          iterator;
+    typedef rna_tree::sibling_iterator  sibling_iterator;
+    typedef rna_tree::post_order_iterator post_order_iterator;
+    
+public:
+    /**
+     * distances between bases are the usual ones of traveler's templates
+     */
+    radial_layout(
+                  rna_tree& _rna);
+    
+    /**
+     * distances between bases are taken from `templated`
+     */
+    radial_layout(
+                  rna_tree& _rna,
+                  const rna_tree& templated);
+    
+    /**
+     * lay out all nodes of rna
+     */
+    void run();
+    
+private:
+    /**
+     * places children of `parent` on circle going through `p1` and `p2`;
+     * loop lies on the right side of vector p1 -> p2
+     */
+    void lay_out_loop(
+                      iterator parent,
+                      point p1,
+                      point p2);
+    
+private:
+    rna_tree& rna;
+    double pairs_distance;
+    double pair_base_distance;
+    double loops_bases_distance;
+    /**
+     * number of nodes in subtree, indexed by node id
+     */
+    std::vector<size_t> subtree_sizes;
+};
+
+#endif /* !RADIAL_LAYOUT_HPP */
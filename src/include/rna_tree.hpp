@@ -22,10 +22,13 @@
 #ifndef RNA_TREE_HPP
 #define RNA_TREE_HPP
 
+#include <memory>
+
 #include "tree_base.hpp"
 #include "rna_tree_label.hpp"
 
 struct point;
+struct rna_tree_flat;
 
 class rna_tree : public tree_base<rna_pair_label>
 {
@@ -62,6 +65,18 @@ public:
      */
     sibling_iterator erase(
                            sibling_iterator sib);
+    /**
+     * erase all nodes marked as deleted in one preorder pass,
+     * children of erased node become children of its parent;
+     * positions of erased nodes in final children of their parents
+     * are stored to parents' remake_ids
+     */
+    void erase_deleted();
+    
+    /**
+     * renumber nodes in postorder, see tree_base::set_postorder_ids()
+     */
+    void set_postorder_ids();
     
     std::string name() const;
     
@@ -108,6 +123,19 @@ public:
     static iterator get_rightest_initiated_descendant(
                                                       const iterator& node);
     
+    /**
+     * returns postorder structure-of-arrays snapshot of tree,
+     * snapshot is cached until tree is changed by insert(), erase(),
+     * update_points() or set_postorder_ids();
+     * changes of labels through iterators are not tracked, see invalidate_flat()
+     */
+    std::shared_ptr<const rna_tree_flat> get_flat() const;
+    
+    /**
+     * drop cached snapshot
+     */
+    void invalidate_flat();
+    
 public:
     static point base_pair_edge_point(
                                       point from,
@@ -146,6 +174,7 @@ private:
     
 private:
     std::string _name;
+    mutable std::shared_ptr<const rna_tree_flat> flat;
     struct
     {
         /**
@@ -163,6 +192,12 @@ private:
     } distances;
 };
 
+/**
+ * shared immutable rna_tree, read-only stages (TED, template library)
+ * share one instance; matcher makes its own copy to be modified
+ */
+typedef std::shared_ptr<const rna_tree> rna_tree_ptr;
+
 inline bool is(
                const rna_tree::base_iterator& iter,
                rna_pair_label::status_type s)
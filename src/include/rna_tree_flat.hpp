@@ -0,0 +1,94 @@
+/*
+ * File: rna_tree_flat.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef RNA_TREE_FLAT_HPP
+#define RNA_TREE_FLAT_HPP
+
+#include <cstdint>
+
+#include "rna_tree.hpp"
+
+/**
+ * immutable structure-of-arrays snapshot of rna_tree
+ *
+ * nodes are indexed by their postorder position (root is last),
+ * for trees with postorder ids index is equal to ::id() of node;
+ * bases are indexed by 2 * node + label_index
+ */
+struct rna_tree_flat
+{
+    typedef std::vector<size_t> index_array;
+    
+    /**
+     * missing node (parent of root, child of leaf, ...)
+     */
+    static const size_t NONE = SIZE_MAX;
+    
+public:
+    rna_tree_flat(
+                  const rna_tree& rna);
+    
+    size_t size() const
+    {
+        return ids.size();
+    }
+    size_t root() const
+    {
+        return size() - 1;
+    }
+    bool is_leaf(
+                 size_t node) const
+    {
+        return first_child[node] == NONE;
+    }
+    
+public:
+    /**
+     * ::id() of nodes
+     */
+    index_array ids;
+    
+    index_array parent;
+    index_array first_child;
+    index_array last_child;
+    index_array next_sibling;
+    index_array subtree_size;
+    index_array leftmost_leaf;
+    index_array depth;
+    
+    std::vector<uint8_t> paired;
+    std::vector<uint8_t> initiated;
+    
+    /**
+     * first character of label of every base, 0 for missing second base of unpaired node
+     */
+    std::vector<char> label_codes;
+    std::vector<double> x;
+    std::vector<double> y;
+    
+    /**
+     * bases in pre-post order of tree (root's bases included), i.e. 5' -> 3'
+     */
+    index_array sequence;
+};
+
+#endif /* !RNA_TREE_FLAT_HPP */
@@ -23,20 +23,63 @@
 #define RNA_TREE_LABEL_HPP
 
 #include <vector>
+#include <cstdint>
 
 #include "tree_base_node.hpp"
 #include "point.hpp"
 
 /**
  * object representing one base
+ *
+ * base is stored inline as one character; labels longer than one character
+ * (root's 5' and 3' ends) are stored as codes into static side table
  */
 struct rna_label
 {
     bool operator==(
                     const rna_label& other) const;
     
-    std::string label;
+    /**
+     * returns text of label
+     */
+    std::string label() const;
+    /**
+     * returns first character of label, 0 for empty label
+     */
+    char first_char() const;
+    /**
+     * set text of label; must be one character or one of side table strings
+     */
+    void set_label(
+                   const std::string& s);
+    
     point p;
+    char base;
+};
+
+/**
+ * set of child indexes; first 64 indexes are stored inline in bitset
+ */
+class child_bitset
+{
+public:
+    void insert(
+                size_t index);
+    bool contains(
+                  size_t index) const;
+    bool empty() const;
+    void clear();
+    /**
+     * returns greatest index in set, set must not be empty
+     */
+    size_t max() const;
+    
+private:
+    uint64_t bits = 0;
+    /**
+     * bits of indexes >= 64, empty for usual nodes
+     */
+    std::vector<uint64_t> overflow;
 };
 
 /**
@@ -45,7 +88,7 @@ struct rna_label
 class rna_pair_label : public node_base
 {
 public:
-    enum status_type
+    enum status_type : uint8_t
     {
         untouched,
         touched,
@@ -61,6 +104,8 @@ public:
     rna_pair_label() = default;
     rna_pair_label(
                    const std::string& s);
+    rna_pair_label(
+                   char base);
     bool operator==(
                     const rna_pair_label& other) const;
     rna_pair_label operator+(
@@ -110,10 +155,15 @@ public:
     
 public:
     status_type status = untouched;
-    std::vector<size_t> remake_ids;
+    child_bitset remake_ids;
+    
+private:
+    void push_back(
+                   const rna_label& label);
     
 private:
-    std::vector<rna_label> labels;
+    rna_label labels[2];
+    uint8_t labels_size = 0;
     point parent_center;
     
 };
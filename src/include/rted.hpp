@@ -22,23 +22,63 @@
 #ifndef RTED_HPP
 #define RTED_HPP
 
+#include <memory>
+
 #include "strategy.hpp"
 #include "rna_tree.hpp"
 
+struct rna_tree_flat;
+
 class rted
 {
 public:
     typedef rna_tree                                    tree_type;
-    typedef typename tree_type::iterator                iterator;
-    typedef typename tree_type::post_order_iterator     post_order_iterator;
+    // trees are shared and only read
+    typedef typename tree_type::const_iterator          iterator;
+    typedef typename tree_type::const_post_order_iterator post_order_iterator;
     typedef typename tree_type::sibling_iterator        sibling_iterator;
     
     typedef std::vector<size_t>                         table_type;
     
+    /**
+     * tables depending only on one tree,
+     * they can be computed once and shared between more rted runs
+     */
+    struct tree_tables
+    {
+        // A == full decomposition
+        table_type A;
+        // F* = relevant subforests tables
+        table_type FLeft;
+        table_type FRight;
+        // subtree sizes
+        table_type Size;
+        
+        /**
+         * compute all tables for tree `t` from its flat snapshot
+         */
+        static std::shared_ptr<const tree_tables> compute(
+                                                          const tree_type& t);
+    };
+    typedef std::shared_ptr<const tree_tables>          tree_tables_ptr;
+    
 public:
+    /**
+     * trees are copied, use rna_tree_ptr to share them
+     */
     rted(
          const tree_type& _t1,
          const tree_type& _t2);
+    rted(
+         const rna_tree_ptr& _t1,
+         const rna_tree_ptr& _t2);
+    /**
+     * use precomputed tables of `_t1`
+     */
+    rted(
+         const rna_tree_ptr& _t1,
+         const tree_tables_ptr& _t1_tables,
+         const rna_tree_ptr& _t2);
     /**
      * run computations
      */
@@ -47,15 +87,12 @@ public:
 private:
     /**
      * initializes tables to their needed size;
-     * compute:
-     *  subtree size
-     *  full decomposition,
-     *  relevant subforest tables
+     * compute tree_tables of trees, if they are not precomputed
      */
     void init();
     
     /**
-     * upgrade full_decomposition tables
+     * upgrade full_decomposition tables of `node` of snapshot `t`
      *
      * ALeft == left_decomposition
      * ARight == right_decomposition
@@ -67,35 +104,28 @@ private:
      *
      * after computing, ALeft[ch1] and ARight[ch1] is not needed
      */
-    void compute_full_decomposition(
-                                    iterator it,
-                                    table_type& A,
-                                    table_type& ALeft,
-                                    table_type& ARight);
+    static void compute_full_decomposition(
+                                           const rna_tree_flat& t,
+                                           size_t node,
+                                           table_type& A,
+                                           table_type& ALeft,
+                                           table_type& ARight);
     
     /**
-     * upgrade relevant_subforests tables of it with respect to left/right path
+     * upgrade relevant_subforests tables of `node` of snapshot `t`
+     * with respect to left/right path
      *
      * FLeft[parent] = 1 + F[mostleft_child] +
      *                  sum(Size[other_children] + F[other_children])
      * FRight[parent] = 1 + F[mostright_child] +
      *                  sum(Size[other_children] + F[other_children])
      */
-    void compute_relevant_subforrests(
-                                      iterator it,
-                                      table_type& FLeft,
-                                      table_type& FRight,
-                                      table_type& Size);
-    
-    /**
-     * update Size table from children:
-     *
-     * Size[parent] = sum(Size[ch]) + 1
-     *  where ch are children
-     */
-    void compute_subtree_size(
-                              iterator it,
-                              table_type& Size);
+    static void compute_relevant_subforrests(
+                                             const rna_tree_flat& t,
+                                             size_t node,
+                                             table_type& FLeft,
+                                             table_type& FRight,
+                                             const table_type& Size);
     
     /**
      * initialize L/R/H_v tables for leaf it1
@@ -179,30 +209,23 @@ public:
     strategy_table_type& get_strategies();
     
 private:
-    tree_type
-    t1,
+    rna_tree_ptr
+    t1_ptr,
+    t2_ptr;
+    const tree_type&
+    t1;
+    const tree_type&
     t2;
     
     strategy_table_type
     STR;
     
     //tables for A(Gw), .., F(Gw), ..
-    table_type
-    // A == full decomposition
-    T1_A,
-    T2_A,
-    
-    // F* = relevant subforests tables
-    T1_FLeft,
-    T1_FRight,
-    
-    T2_FLeft,
-    T2_FRight,
-    
-    // subtree sizes
-    T1_Size,
-    T2_Size,
+    tree_tables_ptr
+    T1,
+    T2;
     
+    table_type
     //main loop, {LRH}w
     T2_Lw,
     T2_Rw,
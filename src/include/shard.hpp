@@ -0,0 +1,103 @@
+/*
+ * File: shard.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include "types.hpp"
+
+/**
+ * part `index` of `count` of batch job list,
+ * jobs are assigned to shards round-robin by their position in list,
+ * so every process computes same partition without coordination
+ */
+struct shard
+{
+    size_t index = 0;
+    size_t count = 1;
+    
+    /**
+     * parse shard from text "i/N", where 0 <= i < N
+     */
+    static shard parse(
+                       const std::string& text);
+    
+    /**
+     * returns if `job`-th job belongs to this shard
+     */
+    bool contains(
+                  size_t job) const
+    {
+        return job % count == index;
+    }
+    
+    /**
+     * returns if shard contains all jobs
+     */
+    bool is_whole() const
+    {
+        return count == 1;
+    }
+    
+    /**
+     * returns filename of partial output `filename` of this shard
+     */
+    std::string get_filename(
+                             const std::string& filename) const;
+};
+
+/**
+ * partial output of one shard, saved as tab-separated text:
+ *  1st line:   type, shard index, shard count
+ *  2nd line:   names of all items in job list
+ *  other:      records
+ */
+struct shard_output
+{
+    std::string type;
+    shard part;
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> records;
+    
+    void save(
+              const std::string& filename) const;
+    
+    static shard_output load(
+                             const std::string& filename);
+    
+    /**
+     * parse non-negative decimal number from record field, throws
+     * invalid_argument or out_of_range if `text` is not a whole number
+     */
+    static size_t parse_number(
+                               const std::string& text);
+    
+    /**
+     * loads partial outputs of all `count` shards of `filename`,
+     * checks if all of them have same type and names
+     */
+    static std::vector<shard_output> load_all(
+                                              const std::string& filename,
+                                              size_t count);
+};
+
+#endif /* !SHARD_HPP */
@@ -0,0 +1,102 @@
+/*
+ * File: ted_cache.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef TED_CACHE_HPP
+#define TED_CACHE_HPP
+
+#include "strategy.hpp"
+#include "rna_tree.hpp"
+
+class mapping;
+
+/**
+ * content-addressed on-disk cache of tree-edit-distance results
+ *
+ * cost model ignores labels, so results depend only on both bracket structures,
+ * TED engine and cost model. Entries are stored in `directory` as
+ *  <hash>.key  - full key, used to detect hash collisions
+ *  <hash>.str  - strategy table (see save_strategy_table())
+ *  <hash>.map  - mapping table (see save_tree_mapping_table())
+ * every file is written to temporary file first and renamed afterwards,
+ * so more processes can share one cache directory
+ */
+class ted_cache
+{
+public:
+    ted_cache(
+              const std::string& directory);
+    
+    /**
+     * returns key identifying TED computation between `templated` and `matched`
+     */
+    static std::string get_key(
+                               const rna_tree& templated,
+                               const rna_tree& matched,
+                               const std::string& engine);
+    
+public:
+    /**
+     * loads mapping stored under `key`, returns false if entry does not exist
+     */
+    bool load_mapping(
+                      const std::string& key,
+                      mapping& map) const;
+    /**
+     * loads strategy table stored under `key`, returns false if entry does not exist
+     */
+    bool load_strategies(
+                         const std::string& key,
+                         strategy_table_type& strategies) const;
+    
+    void save_mapping(
+                      const std::string& key,
+                      const mapping& map) const;
+    void save_strategies(
+                         const std::string& key,
+                         const strategy_table_type& strategies) const;
+    
+private:
+    /**
+     * returns if entry `key` exists and is not hash collision
+     */
+    bool contains_key(
+                      const std::string& key) const;
+    
+    /**
+     * writes key file for `key`, if it is not written yet;
+     * returns false if the entry is taken by another key (hash collision),
+     * data of `key` must not be saved then
+     */
+    bool save_key(
+                  const std::string& key) const;
+    
+    /**
+     * returns filename of entry `key` with `extension`
+     */
+    std::string get_filename(
+                             const std::string& key,
+                             const std::string& extension) const;
+    
+private:
+    std::string directory;
+};
+
+#endif /* !TED_CACHE_HPP */
@@ -0,0 +1,100 @@
+/*
+ * File: ted_lower_bounds.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef TED_LOWER_BOUNDS_HPP
+#define TED_LOWER_BOUNDS_HPP
+
+#include "rna_tree.hpp"
+
+/**
+ * structural summary of rna tree used for cheap lower bounds
+ * of tree-edit-distance computed by gted
+ *
+ * labels are ignored (update costs nothing, see gted::costs),
+ * so all bounds depend only on tree structure
+ */
+struct tree_profile
+{
+    /**
+     * loop types, node type depends only on its children
+     */
+    enum loop_type
+    {
+        LOOP_NONE,          // no children
+        LOOP_HAIRPIN,       // only leaf children
+        LOOP_STACK,         // exactly one inner child
+        LOOP_INTERIOR,      // one inner child and some leafs
+        LOOP_MULTI,         // more inner children
+        
+        LOOP_TYPES_COUNT
+    };
+    
+public:
+    tree_profile() = default;
+    tree_profile(
+                 const rna_tree& rna);
+    
+public:
+    size_t size = 0;
+    /**
+     * histogram of children counts
+     */
+    std::vector<size_t> degrees;
+    /**
+     * histogram of loop types
+     */
+    std::vector<size_t> loops;
+    /**
+     * euler string of tree, each node is written as '(' subtree ')'
+     */
+    std::string euler;
+};
+
+/**
+ * |size1 - size2|
+ */
+size_t size_lower_bound(
+                        const tree_profile& p1,
+                        const tree_profile& p2);
+
+/**
+ * bound from degree histograms and loop histograms
+ *
+ * one insert/delete changes at most 3 entries of degree histogram
+ * (node itself and parent's degree) and at most 5 entries of loop histogram
+ * (node, parent and grandparent, when parent gains/loses its only child)
+ */
+size_t histogram_lower_bound(
+                             const tree_profile& p1,
+                             const tree_profile& p2);
+
+/**
+ * bound from insert/delete edit distance of euler strings,
+ * every deleted/inserted node removes/adds two characters;
+ * computation is stopped when bound reaches `limit`, `limit` is returned then
+ */
+size_t euler_lower_bound(
+                         const tree_profile& p1,
+                         const tree_profile& p2,
+                         size_t limit);
+
+#endif /* !TED_LOWER_BOUNDS_HPP */
@@ -0,0 +1,129 @@
+/*
+ * File: template_library.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef TEMPLATE_LIBRARY_HPP
+#define TEMPLATE_LIBRARY_HPP
+
+#include "ted_lower_bounds.hpp"
+#include "mapping.hpp"
+#include "vp_tree.hpp"
+
+/**
+ * library of template molecules stored in one directory
+ *
+ * each template consists of NAME.fasta file (sequence and structure)
+ * and NAME.ps (crw), NAME.xml (traveler) or NAME.svg (varna) image;
+ * only fasta files are read while indexing, image is extracted
+ * only for chosen template
+ */
+class template_library
+{
+public:
+    struct entry
+    {
+        std::string name;
+        std::string fasta_file;
+        std::string image_file;
+        std::string image_type;
+        
+        rna_tree_ptr rna;
+        tree_profile profile;
+        /**
+         * hash of structure and sequence, see hash_string()
+         */
+        std::string digest;
+    };
+    
+    struct result
+    {
+        size_t index;
+        mapping map;
+        
+        /**
+         * statistics of filtering
+         */
+        size_t pruned_by_histograms = 0;
+        size_t pruned_by_euler = 0;
+        size_t pruned_by_index = 0;
+        /**
+         * templates not pruned by bounds, but skipped because `top`
+         * TED runs were done already
+         */
+        size_t skipped_by_top = 0;
+        size_t ted_runs = 0;
+    };
+    
+public:
+    /**
+     * index all templates in `directory`
+     */
+    template_library(
+                     const std::string& directory);
+    
+    /**
+     * find template with minimal tree-edit-distance to `matched`
+     *
+     * templates are ordered by cheap lower bounds (size, histograms)
+     * and full TED is computed for at most `top` of them;
+     * template is skipped whenever some lower bound reaches best distance found yet
+     */
+    result find_best(
+                     const rna_tree_ptr& matched,
+                     size_t top) const;
+    
+    /**
+     * find template with minimal tree-edit-distance to `matched`
+     * using vp_tree `index` created by create_index()
+     */
+    result find_best(
+                     const rna_tree_ptr& matched,
+                     const vp_tree& index) const;
+    
+    /**
+     * create vp_tree over all templates, TED is computed
+     * between templates to create it
+     */
+    vp_tree create_index() const;
+    
+    /**
+     * returns if `index` was created over same templates (names and content)
+     * with same metric
+     */
+    bool is_valid_index(
+                        const vp_tree& index) const;
+    
+    /**
+     * extract templated rna (with points) of `index`-th template
+     */
+    rna_tree_ptr create_templated(
+                                  size_t index) const;
+    
+    const std::vector<entry>& get_entries() const
+    {
+        return entries;
+    }
+    
+private:
+    std::vector<entry> entries;
+};
+
+#endif /* !TEMPLATE_LIBRARY_HPP */
@@ -34,6 +34,7 @@ public:
 private:
     void test_operations_success();
     void test_operations_fail();
+    void test_init();
 };
 
 #endif /* !COMPACT_CIRCLE_TEST_HPP */
@@ -35,6 +35,7 @@ public:
 
 private:
     void test_gted(rna_tree rna1, rna_tree rna2, size_t distance);
+    void test_prepared_template();
 };
 
 #endif /* !GTED_TEST_HPP */
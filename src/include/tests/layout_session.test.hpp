@@ -0,0 +1,58 @@
+/*
+ * File: layout_session.test.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef LAYOUT_SESSION_TEST_HPP
+#define LAYOUT_SESSION_TEST_HPP
+
+#include "test.test.hpp"
+#include "rna_tree.hpp"
+
+class layout_session_test : public test
+{
+public:
+    layout_session_test();
+    virtual ~layout_session_test() = default;
+    virtual void run();
+
+private:
+    /**
+     * updates session of template to `brackets`/`labels`; bases out of pair
+     * [begin, end] of template have to keep positions (shifted by `shift`
+     * behind the pair) and mapping has to be the same as of full TED
+     */
+    void check_update(
+                      const std::string& brackets,
+                      const std::string& labels,
+                      size_t begin,
+                      size_t end,
+                      size_t shift);
+
+    void test_relabel();
+    void test_hairpin_insertion();
+    void test_new_pair();
+    void test_exterior_loop();
+    void test_no_change();
+
+private:
+    rna_tree_ptr templated;
+};
+
+#endif /* !LAYOUT_SESSION_TEST_HPP */
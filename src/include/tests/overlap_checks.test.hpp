@@ -38,6 +38,14 @@ private:
                 point p1,
                 point p2,
                 bool intersects);
+
+    void test_robust_intersection();
+
+    void test_intersections();
+
+    void test_count_overlaps();
+
+    void test_run();
 };
 
 #endif /* !OVERLAP_CHECKS_TEST_HPP */
@@ -36,6 +36,7 @@ private:
     void test_basics();
     void test_operations();
     void test_functions();
+    void test_affine_transform();
 };
 
 #endif /* !POINT_TEST_HPP */
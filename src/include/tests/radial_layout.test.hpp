@@ -0,0 +1,51 @@
+/*
+ * File: radial_layout.test.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef RADIAL_LAYOUT_TEST_HPP
+#define RADIAL_LAYOUT_TEST_HPP
+
+#include "test.test.hpp"
+
+class rna_tree;
+
+class radial_layout_test : public test
+{
+public:
+    radial_layout_test();
+    virtual ~radial_layout_test() = default;
+    virtual void run();
+
+private:
+    /**
+     * checks that all bases are placed, pairs and stacks have given distances
+     * and bases of every loop lie on one circle with its closing pair
+     */
+    void check_layout(
+                      rna_tree& rna,
+                      double pairs_distance,
+                      double pair_base_distance);
+
+    void test_default_distances();
+    void test_template_distances();
+    void test_tiny_loop();
+};
+
+#endif /* !RADIAL_LAYOUT_TEST_HPP */
@@ -0,0 +1,46 @@
+/*
+ * File: template_library.test.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+#ifndef TEMPLATE_LIBRARY_TEST_HPP
+#define TEMPLATE_LIBRARY_TEST_HPP
+
+#include "test.test.hpp"
+
+class rna_tree;
+
+class template_library_test : public test
+{
+public:
+    template_library_test();
+    virtual ~template_library_test() = default;
+    virtual void run();
+
+private:
+    void test_lower_bounds();
+    void test_find_best();
+    void test_vp_tree();
+    void test_distance_matrix();
+    void test_shards();
+
+    static std::vector<rna_tree> create_trees();
+};
+
+#endif /* !TEMPLATE_LIBRARY_TEST_HPP */
@@ -37,6 +37,7 @@ private:
     void test_exist_file();
     void test_io();
     void test_read_fasta_file();
+    void test_write_file_atomic();
 
     std::string create_fasta_text();
     fasta create_fasta();
@@ -22,9 +22,12 @@
 #ifndef TREE_BASE_HPP
 #define TREE_BASE_HPP
 
+#include <atomic>
+
 #include "tree_hh/tree.hh"
 #undef assert
 #include "types.hpp"
+#include "tree_base_pool.hpp"
 
 //
 // only declarations of classes/functions
@@ -36,9 +39,11 @@ class tree_base
 private:
     class                                           _pre_post_order_iterator;
     class                                           _reverse_post_order_iterator;
+    template <typename iter>
+    class                                           _const_iterator;
     
 protected:
-    typedef tree<label_type>                        tree_type;
+    typedef tree<label_type, pool_allocator<tree_node_<label_type>>> tree_type;
     typedef tree_node_<label_type>                  tree_node_type;
     
 public:
@@ -48,6 +53,8 @@ public:
     typedef typename tree_type::post_order_iterator post_order_iterator;
     typedef _pre_post_order_iterator                pre_post_order_iterator;
     typedef _reverse_post_order_iterator            reverse_post_order_iterator;
+    typedef _const_iterator<iterator>               const_iterator;
+    typedef _const_iterator<post_order_iterator>    const_post_order_iterator;
     
 protected:
     tree_base() = default;
@@ -101,12 +108,12 @@ public:
     inline reverse_post_order_iterator begin_rev_post();
     inline reverse_post_order_iterator end_rev_post();
     
-protected:
-    /* constant functions */
-    inline iterator begin() const;
-    inline iterator end() const;
-    inline post_order_iterator begin_post() const;
-    inline post_order_iterator end_post() const;
+public:
+    /* constant functions, labels cannot be changed through returned iterators */
+    inline const_iterator begin() const;
+    inline const_iterator end() const;
+    inline const_post_order_iterator begin_post() const;
+    inline const_post_order_iterator end_post() const;
     
 public:
     /* STATIC functions: */
@@ -122,19 +129,25 @@ public:
     static iter last_child(
                            const iter& it);
     
+    template <typename iter>
     static bool is_first_child(
-                               const base_iterator& it);
+                               const iter& it);
+    template <typename iter>
     static bool is_last_child(
-                              const base_iterator& it);
+                              const iter& it);
+    template <typename iter>
     static bool is_leaf(
-                        const base_iterator& it);
+                        const iter& it);
+    template <typename iter>
     static bool is_only_child(
-                              const base_iterator& it);
+                              const iter& it);
+    template <typename iter>
     static bool is_root(
-                        const base_iterator& it);
+                        const iter& it);
     
+    template <typename iter>
     static bool is_valid(
-                         const base_iterator& it);
+                         const iter& it);
     
     int depth(
               const base_iterator& it);
@@ -150,7 +163,10 @@ public:
     }
     
 private:
-    static size_t ID;
+    /**
+     * counter of tree ids, trees can be created by more threads
+     */
+    static std::atomic<size_t> ID;
     
 protected:
     size_t _id = ID++;
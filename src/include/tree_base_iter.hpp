@@ -80,6 +80,66 @@ public:
     _reverse_post_order_iterator& operator--();
 };
 
+/**
+ * read-only view of `iter`, labels can not be changed through it;
+ * `node` is visible for static functions of tree_base
+ */
+template <typename label_type>
+template <typename iter>
+class tree_base<label_type>::_const_iterator
+: private iter
+{
+public:
+    _const_iterator() = default;
+    _const_iterator(
+                    const iter& it)
+    : iter(it)
+    { }
+    _const_iterator(
+                    tree_node_type* nodeptr)
+    : iter(nodeptr)
+    { }
+    template <typename other>
+    _const_iterator(
+                    const _const_iterator<other>& it)
+    : iter(it.node)
+    { }
+    
+    using iter::node;
+    
+    const label_type& operator*() const
+    {
+        return iter::operator*();
+    }
+    const label_type* operator->() const
+    {
+        return iter::operator->();
+    }
+    
+    _const_iterator& operator++()
+    {
+        iter::operator++();
+        return *this;
+    }
+    _const_iterator operator++(int)
+    {
+        _const_iterator other = *this;
+        ++(*this);
+        return other;
+    }
+    
+    bool operator==(
+                    const _const_iterator& other) const
+    {
+        return node == other.node;
+    }
+    bool operator!=(
+                    const _const_iterator& other) const
+    {
+        return node != other.node;
+    }
+};
+
 //
 // _pre_post_order_iterator class functions:
 //
@@ -280,31 +340,31 @@ tree_base<label_type>::end_rev_post()
 
 
 //
-// protected TREE->ITERATOR functions:
+// constant TREE->ITERATOR functions:
 //
 template <typename label_type>
-typename tree_base<label_type>::iterator
+typename tree_base<label_type>::const_iterator
 tree_base<label_type>::begin() const
 {
     return _tree.begin();
 }
 
 template <typename label_type>
-typename tree_base<label_type>::iterator
+typename tree_base<label_type>::const_iterator
 tree_base<label_type>::end() const
 {
     return _tree.end();
 }
 
 template <typename label_type>
-typename tree_base<label_type>::post_order_iterator
+typename tree_base<label_type>::const_post_order_iterator
 tree_base<label_type>::begin_post() const
 {
     return _tree.begin_post();
 }
 
 template <typename label_type>
-typename tree_base<label_type>::post_order_iterator
+typename tree_base<label_type>::const_post_order_iterator
 tree_base<label_type>::end_post() const
 {
     return _tree.end_post();
@@ -351,8 +411,9 @@ iter tree_base<label_type>::last_child(
 
 /* static */
 template <typename label_type>
+template <typename iter>
 bool tree_base<label_type>::is_first_child(
-                                           const base_iterator& it)
+                                           const iter& it)
 {
     assert(it.node != nullptr);
     return it.node->prev_sibling == nullptr;
@@ -360,8 +421,9 @@ bool tree_base<label_type>::is_first_child(
 
 /* static */
 template <typename label_type>
+template <typename iter>
 bool tree_base<label_type>::is_last_child(
-                                          const base_iterator& it)
+                                          const iter& it)
 {
     assert(it.node != nullptr);
     return it.node->next_sibling == nullptr;
@@ -369,17 +431,19 @@ bool tree_base<label_type>::is_last_child(
 
 /* static */
 template <typename label_type>
+template <typename iter>
 bool tree_base<label_type>::is_leaf(
-                                    const base_iterator& it)
+                                    const iter& it)
 {
     assert(it.node != nullptr);
-    return it.begin() == it.end();
+    return it.node->first_child == nullptr;
 }
 
 /* static */
 template <typename label_type>
+template <typename iter>
 bool tree_base<label_type>::is_only_child(
-                                          const base_iterator& it)
+                                          const iter& it)
 {
     assert(it.node != nullptr);
     return it.node->prev_sibling == nullptr &&
@@ -388,16 +452,18 @@ bool tree_base<label_type>::is_only_child(
 
 /* static */
 template <typename label_type>
+template <typename iter>
 bool tree_base<label_type>::is_root(
-                                    const base_iterator& it)
+                                    const iter& it)
 {
     return it.node->parent == nullptr;
 }
 
 /* static */
 template <typename label_type>
+template <typename iter>
 bool tree_base<label_type>::is_valid(
-                                     const base_iterator& it)
+                                     const iter& it)
 {
     return it.node != nullptr;
 }
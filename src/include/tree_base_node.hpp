@@ -24,6 +24,10 @@
 
 #include <cstddef>
 
+/**
+ * node ids are owned by tree, they are numbered by tree_base::set_postorder_ids();
+ * copied node keeps id of original
+ */
 class node_base
 {
 public:
@@ -33,13 +37,11 @@ protected:
     
 public:
     size_t id() const;
-    void reset_id();
-    static void reset_ID();
+    void set_id(
+                size_t id);
     
-private:
-    static size_t ID;
 protected:
-    size_t _id = ID++;
+    size_t _id = 0;
 };
 
 #endif /* !TREE_BASE_NODE_HPP */
@@ -0,0 +1,194 @@
+/*
+ * File: tree_base_pool.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef TREE_BASE_POOL_HPP
+#define TREE_BASE_POOL_HPP
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#define TREE_NODE_POOL_MIN_CHUNK    64
+#define TREE_NODE_POOL_MAX_CHUNK    4096
+
+/**
+ * storage of nodes of one tree
+ *
+ * nodes are placed contiguously in chunks in order of their allocation
+ * (tree created from brackets or copied is stored in preorder),
+ * slots of erased nodes are recycled by later allocations;
+ * memory is released with the pool
+ */
+template <typename node_type>
+class tree_node_pool
+{
+public:
+    tree_node_pool() = default;
+    tree_node_pool(
+                   const tree_node_pool&) = delete;
+    tree_node_pool& operator=(
+                              const tree_node_pool&) = delete;
+    
+public:
+    inline node_type* allocate();
+    inline void deallocate(
+                           node_type* node);
+    
+private:
+    union slot
+    {
+        slot* next;
+        alignas(node_type) char storage[sizeof(node_type)];
+    };
+    
+    std::vector<std::unique_ptr<slot[]>> chunks;
+    slot* free_slots = nullptr;
+    size_t chunk_size = 0;
+    size_t chunk_used = 0;
+};
+
+/**
+ * allocator for tree<>, each tree owns its own tree_node_pool;
+ * copies of allocator share the pool
+ */
+template <typename T>
+class pool_allocator
+{
+public:
+    typedef T               value_type;
+    typedef T*              pointer;
+    typedef const T*        const_pointer;
+    typedef T&              reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    
+    template <typename U>
+    struct rebind
+    {
+        typedef pool_allocator<U> other;
+    };
+    
+public:
+    pool_allocator()
+    : pool(std::make_shared<tree_node_pool<T>>())
+    { }
+    
+    inline pointer allocate(
+                            size_type n,
+                            const void* hint = nullptr);
+    inline void deallocate(
+                           pointer p,
+                           size_type n);
+    
+    template <typename... Args>
+    void construct(
+                   pointer p,
+                   Args&&... args)
+    {
+        ::new(static_cast<void*>(p)) T(std::forward<Args>(args)...);
+    }
+    void destroy(
+                 pointer p)
+    {
+        p->~T();
+    }
+    
+    bool operator==(
+                    const pool_allocator& other) const
+    {
+        return pool == other.pool;
+    }
+    bool operator!=(
+                    const pool_allocator& other) const
+    {
+        return pool != other.pool;
+    }
+    
+private:
+    std::shared_ptr<tree_node_pool<T>> pool;
+};
+
+
+
+/* inline */
+template <typename node_type>
+node_type* tree_node_pool<node_type>::allocate()
+{
+    slot* s;
+    
+    if (free_slots != nullptr)
+    {
+        s = free_slots;
+        free_slots = s->next;
+    }
+    else
+    {
+        if (chunk_used == chunk_size)
+        {
+            // chunks grow geometrically, large trees end up in few contiguous blocks
+            chunk_size = chunk_size == 0 ? TREE_NODE_POOL_MIN_CHUNK :
+            std::min<size_t>(2 * chunk_size, TREE_NODE_POOL_MAX_CHUNK);
+            chunks.emplace_back(new slot[chunk_size]);
+            chunk_used = 0;
+        }
+        s = &chunks.back()[chunk_used++];
+    }
+    
+    return reinterpret_cast<node_type*>(s->storage);
+}
+
+/* inline */
+template <typename node_type>
+void tree_node_pool<node_type>::deallocate(
+                                           node_type* node)
+{
+    slot* s = reinterpret_cast<slot*>(node);
+    
+    s->next = free_slots;
+    free_slots = s;
+}
+
+/* inline */
+template <typename T>
+typename pool_allocator<T>::pointer pool_allocator<T>::allocate(
+                                                                size_type n,
+                                                                const void* hint)
+{
+    if (n == 1)
+        return pool->allocate();
+    return std::allocator<T>().allocate(n);
+}
+
+/* inline */
+template <typename T>
+void pool_allocator<T>::deallocate(
+                                   pointer p,
+                                   size_type n)
+{
+    if (n == 1)
+        pool->deallocate(p);
+    else
+        std::allocator<T>().deallocate(p, n);
+}
+
+#endif /* !TREE_BASE_POOL_HPP */
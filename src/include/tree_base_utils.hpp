@@ -23,8 +23,7 @@
 #define TREE_BASE_UTILS_HPP
 
 #include "tree_base.hpp"
-
-#define PSEUDOKNOT_CHARACTERS "[{}]"
+#include "dot_bracket.hpp"
 
 //
 // tree<> functions:
@@ -32,7 +31,7 @@
 
 /* static */
 template <typename label_type>
-size_t tree_base<label_type>::ID = 0;
+std::atomic<size_t> tree_base<label_type>::ID(0);
 
 
 template <typename label_type>
@@ -43,47 +42,40 @@ tree_base<label_type>::tree_base(
 {
     APP_DEBUG_FNAME;
     
-
-    if (_brackets.size() != _labels.size()) {
+    dot_bracket structure = dot_bracket::parse(_brackets);
+    
+    if (structure.size() != _labels.size())
+    {
         std::ostringstream out;
-        for (int i = 0; i < _labels.size(); ++i) out << _labels[i].at(0).label;
+        for (size_t i = 0; i < _labels.size(); ++i)
+            out << _labels[i].at(0).label();
         throw wrong_argument_exception(
-                std::string("\nNumber of brackets != Number of labels\nBrackets: " + _brackets + "\nLabels:   "+out.str()).c_str());
+                                       std::string("\nNumber of brackets != Number of labels\nBrackets: " + _brackets + "\nLabels:   "+out.str()).c_str());
     }
-
-    iterator it;
-    size_t i = 0;
-
-
-    label_type root = label_type("ROOT_" + std::to_string(_id)) + label_type("");
+    
+    label_type root = label_type("ROOT") + label_type("");
     _tree.set_head(root);
     _size = 1;  // ROOT
-    it = begin();
     
-    while(i < _brackets.size())
+    // pairs are known from parsing, so pair node is created complete
+    // at its opening bracket and closing bracket only returns to parent
+    iterator it = begin();
+    for (size_t i = 0; i < structure.size(); ++i)
     {
-        char ch = _brackets[i];
-        if (ch == '(')
+        if (structure.is_opening(i))
         {
-            it = _tree.append_child(it, _labels[i]);
+            it = _tree.append_child(it, _labels[i] + _labels[structure.pairs[i]]);
             ++_size;
         }
-        else if(ch == ')')
+        else if (structure.is_closing(i))
         {
-            assert(!is_root(it));
-            *it = *it + _labels[i];
             it = parent(it);
         }
-        else if (ch == '.' || contains(PSEUDOKNOT_CHARACTERS, ch))
+        else
         {
             _tree.append_child(it, _labels[i]);
             ++_size;
         }
-        else
-        {
-            throw wrong_argument_exception("Invalid dot-bracket character '%s' at index %s", ch, i);
-        }
-        ++i;
     }
     assert(_tree.size() == size());
 }
@@ -167,11 +159,10 @@ void tree_base<label_type>::set_postorder_ids()
     APP_DEBUG_FNAME;
     
     post_order_iterator it;
-    
-    label_type::reset_ID();
+    size_t i = 0;
     
     for (it = begin_post(); it != end_post(); ++it)
-        it->reset_id();
+        it->set_id(i++);
     
     assert(size() - 1 == ::id(begin()));
 }
@@ -180,7 +171,7 @@ template <typename label_type>
 bool tree_base<label_type>::is_ordered_postorder() const
 {
     size_t i = 0;
-    for (post_order_iterator it = begin_post(); it != end_post(); ++it, ++i)
+    for (const_post_order_iterator it = begin_post(); it != end_post(); ++it, ++i)
         if (i != ::id(it))
             return false;
     
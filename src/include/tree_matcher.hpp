@@ -46,6 +46,12 @@ public:
     rna_tree& run(
                   const mapping& m);
     
+    /**
+     * nodes of the tree returned by run() which were touched by mapping,
+     * in preorder: inserted nodes and parents with inserted/deleted children
+     */
+    const std::vector<rna_tree::iterator>& get_edited() const;
+    
 private:
     /**
      * marks nodes with `status`
@@ -54,10 +60,6 @@ private:
               rna_tree& rna,
               const indexes_type& postorder_indexes,
               rna_pair_label::status_type status);
-    /**
-     * erase nodes marked as 'deleted'
-     */
-    void erase();
     /**
      * merge t1 with t2,
      * inserts nodes marked as 'inserted' from t2->t1, rename other
@@ -67,14 +69,10 @@ private:
      * compute subtree sizes for each node in trees
      */
     inline void compute_sizes();
-    /**
-     * unique sort of remake_ids
-     */
-    inline void make_unique(
-                            iterator it);
 private:
     rna_tree t1, t2;
     std::vector<size_t> s1, s2;
+    std::vector<iterator> edited;
 };
 
 #endif /* !TREE_MATCHER_HPP */
@@ -103,7 +103,10 @@ public:
     ~logger_end_of_function_priority();
     
 private:
-    logger::priority old_priority;
+    /**
+     * priority is overridden only in current thread
+     */
+    int old_priority;
 };
 
 struct print_class_BEG_END_name
@@ -87,6 +87,33 @@ void write_file(
                 const std::string& filename,
                 const std::string& text);
 
+/**
+ * call `write_function` with temporary file in same directory
+ * and rename it to `filename` afterwards,
+ * so nobody can read partially written `filename`
+ */
+void write_file_atomic(
+                       const std::string& filename,
+                       const std::function<void(const std::string&)>& write_function);
+
+/**
+ * create directory `dirname`, if it does not exist yet
+ */
+void create_directory(
+                      const std::string& dirname);
+
+/**
+ * returns sorted names of regular files in directory `dirname`
+ */
+std::vector<std::string> list_directory(
+                                        const std::string& dirname);
+
+/**
+ * FNV-1a hash of `str` in hexadecimal notation
+ */
+std::string hash_string(
+                        const std::string& str);
+
 fasta read_fasta_file(
                       const std::string& filename);
 
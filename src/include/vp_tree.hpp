@@ -0,0 +1,129 @@
+/*
+ * File: vp_tree.hpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#ifndef VP_TREE_HPP
+#define VP_TREE_HPP
+
+#include "types.hpp"
+
+/**
+ * vantage-point tree over named items with integer metric
+ *
+ * every node stores vantage point item and ranges of distances
+ * from vantage point to items in its inside/outside subtrees,
+ * so nearest neighbour search needs to compute distances only
+ * to items which cannot be pruned by triangle inequality
+ */
+class vp_tree
+{
+public:
+    /**
+     * distance between `i`-th and `j`-th item
+     */
+    typedef std::function<size_t(size_t, size_t)> distance_function;
+    /**
+     * distance between query and `i`-th item
+     */
+    typedef std::function<size_t(size_t)> query_function;
+    
+    struct result
+    {
+        size_t item;
+        size_t distance;
+        /**
+         * number of query_function calls
+         */
+        size_t evaluations;
+    };
+    
+public:
+    vp_tree() = default;
+    /**
+     * build tree over `names`, `metric` describes used distance;
+     * `digests` identify content of items (empty or one per item),
+     * so changed item can be found although its name is the same
+     */
+    vp_tree(
+            const std::vector<std::string>& names,
+            const std::string& metric,
+            distance_function distance,
+            const std::vector<std::string>& digests = {});
+    
+    /**
+     * returns item nearest to query, using branch and bound search
+     */
+    result find_nearest(
+                        query_function distance) const;
+    
+    const std::vector<std::string>& get_names() const
+    {
+        return names;
+    }
+    const std::string& get_metric() const
+    {
+        return metric;
+    }
+    const std::vector<std::string>& get_digests() const
+    {
+        return digests;
+    }
+    
+public:
+    /**
+     * saves tree to `filename`
+     */
+    void save(
+              const std::string& filename) const;
+    /**
+     * loads tree saved by save()
+     */
+    static vp_tree load(
+                        const std::string& filename);
+    
+private:
+    struct node
+    {
+        size_t item;
+        // indexes to nodes, NONE if subtree is empty
+        size_t inside;
+        size_t outside;
+        // distances from item to items in subtrees are in [min, max]
+        size_t inside_min, inside_max;
+        size_t outside_min, outside_max;
+    };
+    
+    /**
+     * build subtree from items, returns its node index
+     */
+    size_t build(
+                 std::vector<size_t> items,
+                 distance_function& distance);
+    
+private:
+    std::vector<std::string> names;
+    std::vector<std::string> digests;
+    std::string metric;
+    std::vector<node> nodes;
+    size_t root = size_t(-1);
+};
+
+#endif /* !VP_TREE_HPP */
@@ -0,0 +1,235 @@
+/*
+ * File: distance_matrix.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "distance_matrix.hpp"
+#include "prepared_template.hpp"
+#include "mapping.hpp"
+#include "utils.hpp"
+
+#define SHARD_OUTPUT_TYPE   "distance-matrix"
+
+using namespace std;
+
+distance_matrix::distance_matrix(
+                                 const std::vector<rna_tree_ptr>& _rnas,
+                                 const std::vector<std::string>& _names)
+: rnas(_rnas), names(_names)
+{
+    assert(rnas.size() == names.size());
+}
+
+distance_matrix::distance_matrix(
+                                 const std::vector<rna_tree>& _rnas,
+                                 const std::vector<std::string>& _names)
+: names(_names)
+{
+    assert(_rnas.size() == names.size());
+    
+    for (const rna_tree& rna : _rnas)
+        rnas.push_back(make_shared<rna_tree>(rna));
+}
+
+void distance_matrix::run(
+                          size_t threads,
+                          mapping_function on_mapping,
+                          const shard& _part)
+{
+    APP_DEBUG_FNAME;
+    
+    assert(threads != 0);
+    
+    INFO("BEG: Computing distance matrix of %s structures on %s threads", rnas.size(), threads);
+    
+    const size_t n = rnas.size();
+    vector<pair<size_t, size_t>> tasks;
+    vector<shared_ptr<prepared_template>> templates(n);
+    atomic<size_t> next_task(0);
+    exception_ptr error;
+    mutex error_mutex;
+    
+    distances = matrix_type(n, matrix_type::value_type(n, 0));
+    part = _part;
+    
+    // shards take pairs round-robin in canonical order,
+    // larger templates first, so threads finish at similar time
+    for (size_t i = 0, k = 0; i < n; ++i)
+        for (size_t j = i + 1; j < n; ++j, ++k)
+            if (part.contains(k))
+                tasks.push_back({i, j});
+    computed = tasks;
+    stable_sort(tasks.begin(), tasks.end(),
+                [this](const pair<size_t, size_t>& p1, const pair<size_t, size_t>& p2) {
+                    return rnas[p1.first]->size() * rnas[p1.second]->size() >
+                    rnas[p2.first]->size() * rnas[p2.second]->size();
+                });
+    
+    // only read-only template data are shared between threads
+    for (const auto& task : tasks)
+        if (templates[task.first] == nullptr)
+            templates[task.first] = make_shared<prepared_template>(rnas[task.first]);
+    
+    auto worker = [&]()
+    {
+        size_t task;
+        
+        while ((task = next_task++) < tasks.size())
+        {
+            size_t i = tasks[task].first;
+            size_t j = tasks[task].second;
+            
+            try
+            {
+                mapping map = templates[i]->run_ted(rnas[j]);
+                
+                distances[i][j] =
+                distances[j][i] = map.distance;
+                
+                if (on_mapping)
+                {
+                    on_mapping(i, j, map);
+                    on_mapping(j, i, map.reverse());
+                }
+            }
+            catch (...)
+            {
+                lock_guard<mutex> lock(error_mutex);
+                if (error == nullptr)
+                    error = current_exception();
+                next_task = tasks.size();
+            }
+        }
+    };
+    
+    vector<thread> pool;
+    for (size_t t = 1; t < min(threads, tasks.size()); ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool)
+        t.join();
+    
+    if (error != nullptr)
+        rethrow_exception(error);
+    
+    INFO("END: Computing distance matrix of %s structures", rnas.size());
+}
+
+void distance_matrix::save(
+                           const std::string& filename) const
+{
+    APP_DEBUG_FNAME;
+    
+    ostringstream out;
+    
+    for (const string& name : names)
+        out << "\t" << name;
+    out << endl;
+    
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        out << names[i];
+        for (size_t dist : distances[i])
+            out << "\t" << dist;
+        out << endl;
+    }
+    
+    write_file(filename, out.str());
+}
+
+void distance_matrix::save_partial(
+                                   const std::string& filename) const
+{
+    APP_DEBUG_FNAME;
+    
+    shard_output output;
+    
+    output.type = SHARD_OUTPUT_TYPE;
+    output.part = part;
+    output.names = names;
+    for (const auto& p : computed)
+        output.records.push_back({
+            to_string(p.first),
+            to_string(p.second),
+            to_string(distances[p.first][p.second])});
+    
+    output.save(part.get_filename(filename));
+}
+
+/* static */ distance_matrix distance_matrix::merge(
+                                                    const std::string& filename,
+                                                    size_t count)
+{
+    APP_DEBUG_FNAME;
+    
+    vector<shard_output> outputs = shard_output::load_all(filename, count);
+    distance_matrix matrix;
+    size_t n, pairs = 0;
+    vector<vector<bool>> present;
+    
+    if (outputs[0].type != SHARD_OUTPUT_TYPE)
+        throw io_exception("Shard outputs of %s do not contain distance matrix", filename);
+    
+    matrix.names = outputs[0].names;
+    n = matrix.names.size();
+    matrix.distances = matrix_type(n, matrix_type::value_type(n, 0));
+    present = vector<vector<bool>>(n, vector<bool>(n, false));
+    
+    for (const shard_output& output : outputs)
+        for (const auto& record : output.records)
+        {
+            size_t i, j, distance;
+            
+            try
+            {
+                if (record.size() != 3)
+                    throw invalid_argument("record size");
+                
+                i = shard_output::parse_number(record[0]);
+                j = shard_output::parse_number(record[1]);
+                distance = shard_output::parse_number(record[2]);
+            }
+            catch (const logic_error&)
+            {
+                throw io_exception("Shard output %s contains wrong record", output.part.get_filename(filename));
+            }
+            
+            if (i >= j || j >= n)
+                throw io_exception("Shard output %s contains wrong record", output.part.get_filename(filename));
+            if (present[i][j])
+                throw io_exception("Distance of %s and %s is computed by more shards", matrix.names[i], matrix.names[j]);
+            
+            present[i][j] = true;
+            matrix.distances[i][j] =
+            matrix.distances[j][i] = distance;
+            ++pairs;
+        }
+    
+    if (pairs != n * (n - 1) / 2)
+        throw io_exception("Shard outputs of %s contain %s of %s distances", filename, pairs, n * (n - 1) / 2);
+    
+    return matrix;
+}
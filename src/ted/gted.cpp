@@ -28,6 +28,7 @@
 using namespace std;
 
 #define BAD                 0xBADF00D
+#define RANDOM_SEED         1
 
 #define get_table(str, tblname) \
 (str.is_left() ? (tblname).left : \
@@ -40,9 +41,17 @@ using namespace std;
 gted::gted(
            const rna_tree& _t1,
            const rna_tree& _t2)
-: t1(_t1), t2(_t2)
+: gted(std::make_shared<tree_type>(_t1), _t2)
 { }
 
+gted::gted(
+           const tree_ptr& _t1,
+           const rna_tree& _t2)
+: t1_ptr(_t1), t2_ptr(std::make_shared<tree_type>(_t2)), t1(*t1_ptr), t2(*t2_ptr), random(RANDOM_SEED)
+{
+    assert(t1_ptr != nullptr);
+}
+
 void gted::run(
                const strategy_table_type& _str)
 {
@@ -79,7 +88,7 @@ void gted::compute_distance_recursive(
     {
         // heavy decomposition is not implemented. Use left or right one.
         vector<rted_strategy> strategies = {RTED_T1_LEFT, RTED_T1_RIGHT, RTED_T2_LEFT, RTED_T2_RIGHT};
-        str = strategy(strategies.at(rand() % strategies.size()));
+        str = strategy(strategies.at(random() % strategies.size()));
     }
     actual_str = str;
     
@@ -130,8 +139,8 @@ gted::forest_distance_table_type gted::compute_distance(
                                                         iterator root1,
                                                         iterator root2)
 {
-    tree_type *t1ptr = &t1;
-    tree_type *t2ptr = &t2;
+    const tree_type *t1ptr = &t1;
+    const tree_type *t2ptr = &t2;
     forest_distance_table_type table;
     
     if (actual_str.is_T2())
@@ -146,7 +155,7 @@ gted::forest_distance_table_type gted::compute_distance(
     
     if (actual_str.is_left())
     {
-        auto leaf_funct = [](tree_type& t, iterator root) {
+        auto leaf_funct = [](const tree_type& t, iterator root) {
             return t.get_leafs(root).left;
         };
         table = compute_distance_LR<post_order_iterator>(
@@ -168,8 +177,8 @@ template <typename iterator_type, typename funct_get_begin>
 gted::forest_distance_table_type gted::compute_distance_LR(
                                                            iterator root1,
                                                            iterator root2,
-                                                           tree_type& t1,
-                                                           tree_type& t2,
+                                                           const tree_type& t1,
+                                                           const tree_type& t2,
                                                            funct_get_begin get_begin_leaf)
 {
     // subtree has id-s (id(leafs.left) ... id(root1))
@@ -253,6 +262,13 @@ get_fdist(fdist, iter1, iter2, id1, id2)
 #undef prev
 }
 
+size_t gted::get_distance() const
+{
+    assert(!tdist.empty());
+    
+    return tdist[id(t1.begin())][id(t2.begin())];
+}
+
 mapping gted::get_mapping()
 {
     APP_DEBUG_FNAME;
@@ -536,3 +552,8 @@ get_fdist(fdist, iter1, iter2, id1, id2)
         return GTED_COST_MODIFY;
 }
 
+/* static */ std::string gted::costs::description()
+{
+    return msprintf("del=%s;ins=%s;upd=%s;root=%s",
+                    GTED_COST_DELETE, GTED_COST_INSERT, GTED_COST_MODIFY, GTED_COST_ROOT);
+}
@@ -58,6 +58,21 @@ mapping::indexes mapping::get_to_remove() const
     return vec;
 }
 
+mapping mapping::reverse() const
+{
+    APP_DEBUG_FNAME;
+    
+    mapping reversed;
+    
+    reversed.distance = distance;
+    reversed.map.reserve(map.size());
+    for (const auto& m : map)
+        reversed.map.push_back({m.to, m.from});
+    sort(reversed.map.begin(), reversed.map.end());
+    
+    return reversed;
+}
+
 
 bool mapping::mapping_pair::operator<(
                                       const mapping_pair& other) const
@@ -0,0 +1,85 @@
+/*
+ * File: prepared_template.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "prepared_template.hpp"
+#include "mapping.hpp"
+
+using namespace std;
+
+prepared_template::prepared_template(
+                                     const rna_tree_ptr& templated)
+: rna(templated)
+{
+    APP_DEBUG_FNAME;
+    
+    assert(rna != nullptr);
+    
+    INFO("BEG: Preparing template %s", rna->name());
+    
+    rted_tables = rted::tree_tables::compute(*rna);
+    gted_tree_ptr = make_shared<gted_tree>(*rna);
+    
+    INFO("END: Preparing template %s", rna->name());
+}
+
+prepared_template::prepared_template(
+                                     const rna_tree& templated)
+: prepared_template(make_shared<rna_tree>(templated))
+{ }
+
+rted prepared_template::get_rted(
+                                 const rna_tree_ptr& matched) const
+{
+    return rted(rna, rted_tables, matched);
+}
+
+rted prepared_template::get_rted(
+                                 const rna_tree& matched) const
+{
+    return get_rted(make_shared<rna_tree>(matched));
+}
+
+gted prepared_template::get_gted(
+                                 const rna_tree& matched) const
+{
+    return gted(gted_tree_ptr, matched);
+}
+
+mapping prepared_template::run_ted(
+                                   const rna_tree_ptr& matched) const
+{
+    APP_DEBUG_FNAME;
+    
+    rted r = get_rted(matched);
+    r.run();
+    
+    gted g = get_gted(*matched);
+    g.run(r.get_strategies());
+    
+    return g.get_mapping();
+}
+
+mapping prepared_template::run_ted(
+                                   const rna_tree& matched) const
+{
+    return run_ted(make_shared<rna_tree>(matched));
+}
@@ -21,6 +21,7 @@
 
 
 #include "rted.hpp"
+#include "rna_tree_flat.hpp"
 
 #define RTED_BAD        size_t(-0xBADF00D)
 #define isbad(value)    ((value) == RTED_BAD)
@@ -33,10 +34,29 @@ using namespace std;
 rted::rted(
            const tree_type& _t1,
            const tree_type& _t2)
-: t1(_t1), t2(_t2)
+: rted(make_shared<tree_type>(_t1), make_shared<tree_type>(_t2))
+{ }
+
+rted::rted(
+           const rna_tree_ptr& _t1,
+           const rna_tree_ptr& _t2)
+: t1_ptr(_t1), t2_ptr(_t2), t1(*t1_ptr), t2(*t2_ptr)
+{
+    APP_DEBUG_FNAME;
+    
+    check_postorder();
+}
+
+rted::rted(
+           const rna_tree_ptr& _t1,
+           const tree_tables_ptr& _t1_tables,
+           const rna_tree_ptr& _t2)
+: t1_ptr(_t1), t2_ptr(_t2), t1(*t1_ptr), t2(*t2_ptr), T1(_t1_tables)
 {
     APP_DEBUG_FNAME;
     
+    assert(T1 != nullptr && T1->Size.size() == t1.size());
+    
     check_postorder();
 }
 
@@ -106,120 +126,112 @@ void rted::init()
     T2_Hw_partials.resize(size2);
     T1_Hv_partials.resize(size1, partial_result_arr(size2));
     
+    DEBUG("END prepare tables");
+    DEBUG("BEG precomputation");
+    
+    // precompute full-decomposition/relevant-subforest tables:
+    if (T1 == nullptr)
+        T1 = tree_tables::compute(t1);
+    else
+        DEBUG("Using precomputed tables for %s", t1.name());
+    T2 = tree_tables::compute(t2);
+    
+    DEBUG("END precomputation");
+}
+
+/* static */ rted::tree_tables_ptr rted::tree_tables::compute(
+                                                              const tree_type& t)
+{
+    APP_DEBUG_FNAME;
+    
+    shared_ptr<const rna_tree_flat> flat = t.get_flat();
+    size_t size = flat->size();
+    std::shared_ptr<tree_tables> tables = std::make_shared<tree_tables>();
+    
     // A* = decomposition tables.
     // ALeft/ARight == left/right decomposition
-    // T_ALeft/ARight -> only to compute T_A
-    table_type T1_ALeft, T1_ARight, T2_ALeft, T2_ARight;
+    // ALeft/ARight -> only to compute A
+    table_type ALeft, ARight;
     
     // initialize all tables to size of tree..
-    for (auto table : {&T1_ALeft, &T1_ARight, &T1_A,
-        &T1_FLeft, &T1_FRight, &T1_Size})
-        table->resize(size1, RTED_BAD);
-    for (auto table : {&T2_ALeft, &T2_ARight, &T2_A,
-        &T2_FLeft, &T2_FRight, &T2_Size})
-        table->resize(size2, RTED_BAD);
-    
-    DEBUG("END prepare tables");
-    DEBUG("BEG precomputation");
+    for (auto table : {&ALeft, &ARight, &tables->A,
+        &tables->FLeft, &tables->FRight})
+        table->resize(size, RTED_BAD);
+    tables->Size = flat->subtree_size;
     
-    // precompute full-decomposition/relevant-subforest tables:
-    for (post_order_iterator it = t1.begin_post(); it != t1.end_post(); ++it)
-    {
-        compute_full_decomposition(it, T1_A, T1_ALeft, T1_ARight);
-        compute_subtree_size(it, T1_Size);
-        compute_relevant_subforrests(it, T1_FLeft, T1_FRight, T1_Size);
-    }
-    for (post_order_iterator it = t2.begin_post(); it != t2.end_post(); ++it)
+    // snapshot is in postorder, tables are indexed by postorder ids
+    for (size_t node = 0; node < size; ++node)
     {
-        compute_full_decomposition(it, T2_A, T2_ALeft, T2_ARight);
-        compute_subtree_size(it, T2_Size);
-        compute_relevant_subforrests(it, T2_FLeft, T2_FRight, T2_Size);
+        assert(flat->ids[node] == node);
+        
+        compute_full_decomposition(*flat, node, tables->A, ALeft, ARight);
+        compute_relevant_subforrests(*flat, node, tables->FLeft, tables->FRight, tables->Size);
     }
-    assert(T1_Size[id(t1.begin())] == t1.size());
-    assert(T2_Size[id(t2.begin())] == t2.size());
+    assert(tables->Size[flat->root()] == t.size());
     
-    DEBUG("END precomputation");
+    return tables;
 }
 
-void rted::compute_full_decomposition(
-                                      iterator it,
-                                      table_type& A,
-                                      table_type& ALeft,
-                                      table_type& ARight)
+/* static */ void rted::compute_full_decomposition(
+                                                   const rna_tree_flat& t,
+                                                   size_t node,
+                                                   table_type& A,
+                                                   table_type& ALeft,
+                                                   table_type& ARight)
 {
-    size_t it_id = id(it);
+    const rna_tree_flat::index_array& next = t.next_sibling;
     size_t a, left, right;
-    size_t ch_id;
-    sibling_iterator ch, ch2;
     
     a =
     left =
     right = 1;
     
     
-    for (ch = it.begin(); ch != it.end(); ++ch)
+    for (size_t ch = t.first_child[node]; ch != rna_tree_flat::NONE; ch = next[ch])
     {
-        ch_id = id(ch);
-        
-        a       += A[ch_id];
-        left    += ALeft[ch_id];
-        right   += ARight[ch_id];
+        a       += A[ch];
+        left    += ALeft[ch];
+        right   += ARight[ch];
         
-        ch2 = ch;
-        ++ch2;
-        for (; ch2 != it.end(); ++ch2)
-            a += ALeft[ch_id] * ARight[id(ch2)];
+        for (size_t ch2 = next[ch]; ch2 != rna_tree_flat::NONE; ch2 = next[ch2])
+            a += ALeft[ch] * ARight[ch2];
     }
     
-    A[it_id]        = a;
-    ALeft[it_id]    = left;
-    ARight[it_id]   = right;
+    A[node]         = a;
+    ALeft[node]     = left;
+    ARight[node]    = right;
 }
 
-void rted::compute_relevant_subforrests(
-                                        iterator it,
-                                        table_type& FLeft,
-                                        table_type& FRight,
-                                        table_type& Size)
+/* static */ void rted::compute_relevant_subforrests(
+                                                     const rna_tree_flat& t,
+                                                     size_t node,
+                                                     table_type& FLeft,
+                                                     table_type& FRight,
+                                                     const table_type& Size)
 {
-    size_t it_id = id(it);
+    const rna_tree_flat::index_array& next = t.next_sibling;
     size_t left, right;
-    sibling_iterator beg, end;
     
     left = 1;
     right = 1;
     
-    if (!tree_type::is_leaf(it))
+    if (!t.is_leaf(node))
     {
+        size_t first = t.first_child[node];
+        size_t last = t.last_child[node];
+        
         // FLeft
-        left += FLeft[id(tree_type::first_child(it))];
-        beg = ++it.begin();
-        end = it.end();
-        for (; beg != end; ++beg)
-            left += Size[id(beg)] + FLeft[id(beg)];
+        left += FLeft[first];
+        for (size_t ch = next[first]; ch != rna_tree_flat::NONE; ch = next[ch])
+            left += Size[ch] + FLeft[ch];
         
         // FRight
-        right += FRight[id(tree_type::last_child(it))];
-        beg = it.begin();
-        end = tree_type::last_child(it);
-        for (; beg != end; ++beg)
-            right += Size[id(beg)] + FRight[id(beg)];
+        right += FRight[last];
+        for (size_t ch = first; ch != last; ch = next[ch])
+            right += Size[ch] + FRight[ch];
     }
-    FLeft[it_id]    = left;
-    FRight[it_id]   = right;
-}
-
-void rted::compute_subtree_size(
-                                iterator it,
-                                table_type& Size)
-{
-    size_t it_id = id(it);
-    size_t s = 1;
-    
-    for (sibling_iterator ch = it.begin(); ch != it.end(); ++ch)
-        s += Size[id(ch)];
-    
-    Size[it_id] = s;
+    FLeft[node]     = left;
+    FRight[node]    = right;
 }
 
 void rted::init_T1_LRH_v_tables(
@@ -354,22 +366,22 @@ size_t rted::update_STR_table(
     
     //      |T1v| * |FLeft(T2w)| + Lv[v,w]
     vec[RTED_T1_LEFT] =
-    T1_Size[it1_id] * T2_FLeft[it2_id] + T1_Lv[it1_id][it2_id];
+    T1->Size[it1_id] * T2->FLeft[it2_id] + T1_Lv[it1_id][it2_id];
     //      |T2w| * |FLeft(T1v)| + Lw[w]
     vec[RTED_T2_LEFT] =
-    T2_Size[it2_id] * T1_FLeft[it1_id] + T2_Lw[it2_id];
+    T2->Size[it2_id] * T1->FLeft[it1_id] + T2_Lw[it2_id];
     //      |T1v| * |FRight(T2w)| + Rv[v,w]
     vec[RTED_T1_RIGHT] =
-    T1_Size[it1_id] * T2_FRight[it2_id] + T1_Rv[it1_id][it2_id];
+    T1->Size[it1_id] * T2->FRight[it2_id] + T1_Rv[it1_id][it2_id];
     //      |T2w| * |FRight(T1v)| + Rw[w]
     vec[RTED_T2_RIGHT] =
-    T2_Size[it2_id] * T1_FRight[it1_id] + T2_Rw[it2_id];
+    T2->Size[it2_id] * T1->FRight[it1_id] + T2_Rw[it2_id];
     //      |T1v| * |A(T2w)| + Hv[v,w]
     vec[RTED_T1_HEAVY] =
-    T1_Size[it1_id] * T2_A[it2_id] + T1_Hv[it1_id][it2_id];
+    T1->Size[it1_id] * T2->A[it2_id] + T1_Hv[it1_id][it2_id];
     //      |T2w| * |A(T1v)| + Hw[w]
     vec[RTED_T2_HEAVY] =
-    T2_Size[it2_id] * T1_A[it1_id] + T2_Hw[it2_id];
+    T2->Size[it2_id] * T1->A[it1_id] + T2_Hw[it2_id];
     
     auto c_min_it = min_element(vec.begin(), vec.end());
     size_t c_min = *c_min_it;
@@ -420,11 +432,11 @@ void rted::update_T1_LRH_v_tables(
     auto res = T1_Hv_partials[parent1_id][it2_id];
     size_t val;
     
-    if (T1_Size[it1_id] > res.subtree_size)
+    if (T1->Size[it1_id] > res.subtree_size)
     {
         val = T1_Hv[it1_id][it2_id] - res.H_value + res.c_min;
         
-        res.subtree_size = T1_Size[it1_id];
+        res.subtree_size = T1->Size[it1_id];
         res.c_min = c_min;
         res.H_value = T1_Hv[it1_id][it2_id];
         
@@ -474,12 +486,12 @@ void rted::update_T2_LRH_w_tables(
     // Hw:
     auto res = T2_Hw_partials[parent2_id];
     
-    if (T2_Size[it2_id] > res.subtree_size)
+    if (T2->Size[it2_id] > res.subtree_size)
     {
         T2_Hw[parent2_id] +=
         T2_Hw[it2_id] - res.H_value + res.c_min;
         
-        res.subtree_size = T2_Size[it2_id];
+        res.subtree_size = T2->Size[it2_id];
         res.c_min = c_min;
         res.H_value = T2_Hw[it2_id];
         
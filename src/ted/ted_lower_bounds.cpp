@@ -0,0 +1,168 @@
+/*
+ * File: ted_lower_bounds.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "ted_lower_bounds.hpp"
+#include "rna_tree_flat.hpp"
+
+using namespace std;
+
+#define DEGREE_EDIT_CHANGES     3
+#define LOOP_EDIT_CHANGES       5
+
+#define divide_up(a, b)         (((a) + (b) - 1) / (b))
+
+tree_profile::tree_profile(
+                           const rna_tree& rna)
+: size(rna.size()), loops(LOOP_TYPES_COUNT, 0)
+{
+    APP_DEBUG_FNAME;
+    
+    shared_ptr<const rna_tree_flat> flat = rna.get_flat();
+    const rna_tree_flat& t = *flat;
+    
+    for (size_t node = 0; node < t.size(); ++node)
+    {
+        size_t leafs = 0;
+        size_t inner = 0;
+        
+        for (size_t ch = t.first_child[node]; ch != rna_tree_flat::NONE; ch = t.next_sibling[ch])
+        {
+            if (t.is_leaf(ch))
+                ++leafs;
+            else
+                ++inner;
+        }
+        
+        if (degrees.size() <= leafs + inner)
+            degrees.resize(leafs + inner + 1, 0);
+        ++degrees[leafs + inner];
+        
+        if (inner == 0)
+            ++loops[leafs == 0 ? LOOP_NONE : LOOP_HAIRPIN];
+        else if (inner == 1)
+            ++loops[leafs == 0 ? LOOP_STACK : LOOP_INTERIOR];
+        else
+            ++loops[LOOP_MULTI];
+    }
+    
+    // common root is not needed in euler string
+    euler.reserve(2 * size);
+    for (size_t base : t.sequence)
+    {
+        size_t node = base / 2;
+        
+        if (node == t.root())
+            continue;
+        if (t.is_leaf(node))
+            euler += "()";
+        else
+            euler += base % 2 == 0 ? '(' : ')';
+    }
+}
+
+/* global */ size_t size_lower_bound(
+                                     const tree_profile& p1,
+                                     const tree_profile& p2)
+{
+    return p1.size > p2.size ? p1.size - p2.size : p2.size - p1.size;
+}
+
+/* global */ size_t histogram_lower_bound(
+                                          const tree_profile& p1,
+                                          const tree_profile& p2)
+{
+    auto l1_distance = [](const vector<size_t>& h1, const vector<size_t>& h2)
+    {
+        size_t dist = 0;
+        
+        for (size_t i = 0; i < max(h1.size(), h2.size()); ++i)
+        {
+            size_t v1 = i < h1.size() ? h1[i] : 0;
+            size_t v2 = i < h2.size() ? h2[i] : 0;
+            
+            dist += v1 > v2 ? v1 - v2 : v2 - v1;
+        }
+        return dist;
+    };
+    
+    size_t degrees = divide_up(l1_distance(p1.degrees, p2.degrees), DEGREE_EDIT_CHANGES);
+    size_t loops = divide_up(l1_distance(p1.loops, p2.loops), LOOP_EDIT_CHANGES);
+    
+    return max(degrees, loops);
+}
+
+/* global */ size_t euler_lower_bound(
+                                      const tree_profile& p1,
+                                      const tree_profile& p2,
+                                      size_t limit)
+{
+    // banded insert/delete distance of euler strings, only cells
+    // with |i - j| <= band can have distance lower than 2 * limit
+    const string& s1 = p1.euler;
+    const string& s2 = p2.euler;
+    const size_t n = s1.size();
+    const size_t m = s2.size();
+    const size_t band = 2 * limit;
+    const size_t inf = band + 1;
+    
+    if (limit == 0)
+        return 0;
+    if ((n > m ? n - m : m - n) >= band)
+        return limit;
+    
+    vector<size_t> prev(m + 1, inf), act(m + 1, inf);
+    
+    for (size_t j = 0; j <= min(m, band); ++j)
+        prev[j] = j;
+    
+    for (size_t i = 1; i <= n; ++i)
+    {
+        size_t from = i > band ? i - band : 0;
+        size_t to = min(m, i + band);
+        size_t row_min = inf;
+        
+        fill(act.begin() + (from > 0 ? from - 1 : 0), act.begin() + to + 1, inf);
+        
+        for (size_t j = from; j <= to; ++j)
+        {
+            size_t val;
+            
+            if (j == 0)
+                val = i;
+            else
+            {
+                val = min(prev[j], act[j - 1]) + 1;
+                if (s1[i - 1] == s2[j - 1])
+                    val = min(val, prev[j - 1]);
+            }
+            act[j] = min(val, inf);
+            row_min = min(row_min, act[j]);
+        }
+        
+        if (row_min >= band)
+            return limit;
+        
+        swap(prev, act);
+    }
+    
+    return min(divide_up(prev[m], 2), limit);
+}
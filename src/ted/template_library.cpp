@@ -0,0 +1,259 @@
+/*
+ * File: template_library.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <cstdint>
+
+#include "template_library.hpp"
+#include "prepared_template.hpp"
+#include "extractor.hpp"
+#include "utils.hpp"
+
+#define FASTA_EXTENSION     ".fasta"
+#define INDEX_METRIC        ("ted;" + gted::costs::description())
+
+using namespace std;
+
+template_library::template_library(
+                                   const std::string& directory)
+{
+    APP_DEBUG_FNAME;
+    
+    // image extensions and their extractors, ordered by priority
+    const vector<pair<string, string>> image_types = {
+        {".ps", "crw"},
+        {".xml", "traveler"},
+        {".svg", "varna"},
+    };
+    vector<string> files = list_directory(directory);
+    
+    auto ends_with = [](const string& str, const string& suffix)
+    {
+        return str.size() > suffix.size() &&
+        str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    
+    for (const string& file : files)
+    {
+        if (!ends_with(file, FASTA_EXTENSION))
+            continue;
+        
+        entry e;
+        e.name = file.substr(0, file.size() - string(FASTA_EXTENSION).size());
+        e.fasta_file = directory + "/" + file;
+        
+        for (const auto& type : image_types)
+        {
+            if (binary_search(files.begin(), files.end(), e.name + type.first))
+            {
+                e.image_file = directory + "/" + e.name + type.first;
+                e.image_type = type.second;
+                break;
+            }
+        }
+        if (e.image_file.empty())
+        {
+            WARN("Template library: skipping %s, no image found", e.fasta_file);
+            continue;
+        }
+        
+        fasta f = read_fasta_file(e.fasta_file);
+        e.rna = make_shared<rna_tree>(f.brackets, f.labels, e.name);
+        e.profile = tree_profile(*e.rna);
+        e.digest = hash_string(f.brackets + "\n" + f.labels);
+        
+        entries.push_back(e);
+    }
+    
+    if (entries.empty())
+        throw io_exception("Template library %s does not contain any template", directory);
+    
+    INFO("Template library %s: indexed %s templates", directory, entries.size());
+}
+
+template_library::result template_library::find_best(
+                                                     const rna_tree_ptr& matched,
+                                                     size_t top) const
+{
+    APP_DEBUG_FNAME;
+    
+    assert(top != 0);
+    
+    tree_profile profile(*matched);
+    vector<size_t> bounds(entries.size());
+    vector<size_t> order(entries.size());
+    size_t best_distance = SIZE_MAX;
+    result res;
+    
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        bounds[i] = max(size_lower_bound(entries[i].profile, profile),
+                        histogram_lower_bound(entries[i].profile, profile));
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(),
+                [&bounds](size_t i, size_t j) {
+                    return bounds[i] < bounds[j];
+                });
+    
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const entry& e = entries[order[i]];
+        
+        if (bounds[order[i]] >= best_distance)
+        {
+            // order is sorted by bounds, so all others are worse too
+            res.pruned_by_histograms += order.size() - i;
+            break;
+        }
+        if (res.ted_runs == top)
+        {
+            // others are skipped, some of them would be pruned by bounds anyway
+            for (size_t j = i; j < order.size(); ++j)
+            {
+                if (bounds[order[j]] >= best_distance)
+                    ++res.pruned_by_histograms;
+                else
+                    ++res.skipped_by_top;
+            }
+            break;
+        }
+        if (res.ted_runs != 0 &&
+            euler_lower_bound(e.profile, profile, best_distance) >= best_distance)
+        {
+            DEBUG("Template %s pruned by euler string bound", e.name);
+            ++res.pruned_by_euler;
+            continue;
+        }
+        
+        mapping map = prepared_template(e.rna).run_ted(matched);
+        ++res.ted_runs;
+        
+        INFO("Template %s: lower bound %s, distance %s", e.name, bounds[order[i]], map.distance);
+        
+        if (map.distance < best_distance)
+        {
+            best_distance = map.distance;
+            res.index = order[i];
+            res.map = map;
+        }
+    }
+    
+    return res;
+}
+
+template_library::result template_library::find_best(
+                                                     const rna_tree_ptr& matched,
+                                                     const vp_tree& index) const
+{
+    APP_DEBUG_FNAME;
+    
+    assert(is_valid_index(index));
+    
+    result res;
+    
+    auto distance = [this, &matched, &res](size_t i)
+    {
+        mapping map = prepared_template(entries[i].rna).run_ted(matched);
+        
+        INFO("Template %s: distance %s", entries[i].name, map.distance);
+        
+        if (res.ted_runs == 0 || map.distance < res.map.distance)
+        {
+            res.index = i;
+            res.map = map;
+        }
+        ++res.ted_runs;
+        
+        return map.distance;
+    };
+    
+    vp_tree::result nearest = index.find_nearest(distance);
+    
+    assert(nearest.item == res.index && nearest.evaluations == res.ted_runs);
+    res.pruned_by_index = entries.size() - res.ted_runs;
+    
+    return res;
+}
+
+vp_tree template_library::create_index() const
+{
+    APP_DEBUG_FNAME;
+    
+    INFO("BEG: Creating index of template library");
+    
+    vector<string> names, digests;
+    for (const entry& e : entries)
+    {
+        names.push_back(e.name);
+        digests.push_back(e.digest);
+    }
+    
+    // vp_tree asks for distances from one vantage point in row,
+    // so its prepared template is reused
+    shared_ptr<prepared_template> templ;
+    size_t templ_index = 0;
+    
+    auto distance = [this, &templ, &templ_index](size_t i, size_t j)
+    {
+        if (templ == nullptr || templ_index != i)
+        {
+            templ = make_shared<prepared_template>(entries[i].rna);
+            templ_index = i;
+        }
+        return templ->run_ted(entries[j].rna).distance;
+    };
+    
+    vp_tree index(names, INDEX_METRIC, distance, digests);
+    
+    INFO("END: Creating index of template library");
+    
+    return index;
+}
+
+bool template_library::is_valid_index(
+                                      const vp_tree& index) const
+{
+    if (index.get_metric() != INDEX_METRIC ||
+        index.get_names().size() != entries.size() ||
+        index.get_digests().size() != entries.size())
+        return false;
+    
+    // template edited under the same name has stale distances in index
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (index.get_names()[i] != entries[i].name ||
+            index.get_digests()[i] != entries[i].digest)
+            return false;
+    
+    return true;
+}
+
+rna_tree_ptr template_library::create_templated(
+                                                size_t index) const
+{
+    APP_DEBUG_FNAME;
+    
+    const entry& e = entries.at(index);
+    extractor_ptr doc = extractor::get_extractor(e.image_file, e.image_type);
+    fasta f = read_fasta_file(e.fasta_file);
+    
+    return make_shared<rna_tree>(f.brackets, doc->labels, doc->points, f.id);
+}
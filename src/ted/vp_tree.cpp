@@ -0,0 +1,257 @@
+/*
+ * File: vp_tree.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <fstream>
+
+#include "vp_tree.hpp"
+#include "utils.hpp"
+
+#define NONE                size_t(-1)
+#define FILE_HEADER         "vp_tree 2"
+
+using namespace std;
+
+vp_tree::vp_tree(
+                 const std::vector<std::string>& _names,
+                 const std::string& _metric,
+                 distance_function distance,
+                 const std::vector<std::string>& _digests)
+: names(_names), digests(_digests), metric(_metric)
+{
+    APP_DEBUG_FNAME;
+    
+    assert(digests.empty() || digests.size() == names.size());
+    
+    vector<size_t> items(names.size());
+    for (size_t i = 0; i < items.size(); ++i)
+        items[i] = i;
+    
+    root = build(items, distance);
+}
+
+size_t vp_tree::build(
+                      std::vector<size_t> items,
+                      distance_function& distance)
+{
+    if (items.empty())
+        return NONE;
+    
+    node n;
+    vector<pair<size_t, size_t>> dist;  // (distance, item)
+    vector<size_t> inside, outside;
+    
+    n.item = items.front();
+    
+    for (size_t i = 1; i < items.size(); ++i)
+        dist.push_back({distance(n.item, items[i]), items[i]});
+    sort(dist.begin(), dist.end());
+    
+    // items with distance <= median go inside
+    size_t median = dist.empty() ? 0 : dist[(dist.size() - 1) / 2].first;
+    
+    n.inside_min = n.outside_min = NONE;
+    n.inside_max = n.outside_max = 0;
+    for (const auto& p : dist)
+    {
+        if (p.first <= median)
+        {
+            inside.push_back(p.second);
+            n.inside_min = min(n.inside_min, p.first);
+            n.inside_max = max(n.inside_max, p.first);
+        }
+        else
+        {
+            outside.push_back(p.second);
+            n.outside_min = min(n.outside_min, p.first);
+            n.outside_max = max(n.outside_max, p.first);
+        }
+    }
+    
+    n.inside = build(inside, distance);
+    n.outside = build(outside, distance);
+    
+    nodes.push_back(n);
+    return nodes.size() - 1;
+}
+
+vp_tree::result vp_tree::find_nearest(
+                                      query_function distance) const
+{
+    APP_DEBUG_FNAME;
+    
+    assert(root != NONE);
+    
+    result res = {NONE, NONE, 0};
+    
+    // lower bound of distance between query and items in subtree,
+    // when distances from vantage point to them are in [min, max]
+    auto lower_bound = [](size_t d, size_t min, size_t max)
+    {
+        if (d < min)
+            return min - d;
+        if (d > max)
+            return d - max;
+        return size_t(0);
+    };
+    
+    function<void(size_t)> search =
+    [&](size_t index)
+    {
+        const node& n = nodes[index];
+        size_t d = distance(n.item);
+        ++res.evaluations;
+        
+        if (d < res.distance)
+        {
+            res.distance = d;
+            res.item = n.item;
+        }
+        
+        size_t in = n.inside == NONE ? NONE : lower_bound(d, n.inside_min, n.inside_max);
+        size_t out = n.outside == NONE ? NONE : lower_bound(d, n.outside_min, n.outside_max);
+        
+        // visit more promising subtree first,
+        // subtree is pruned if it cannot contain nearer item
+        if (out < in)
+        {
+            if (out < res.distance)
+                search(n.outside);
+            if (in < res.distance)
+                search(n.inside);
+        }
+        else
+        {
+            if (in < res.distance)
+                search(n.inside);
+            if (out < res.distance)
+                search(n.outside);
+        }
+    };
+    search(root);
+    
+    DEBUG("vp_tree: nearest %s, distance %s, %s evaluations of %s items",
+          names[res.item], res.distance, res.evaluations, names.size());
+    
+    return res;
+}
+
+void vp_tree::save(
+                   const std::string& filename) const
+{
+    APP_DEBUG_FNAME;
+    
+    auto write = [this](const string& file)
+    {
+        ofstream out(file);
+        
+        out
+        << FILE_HEADER << endl
+        << metric << endl
+        << names.size() << endl;
+        for (const string& name : names)
+            out << name << endl;
+        
+        out
+        << digests.size() << endl;
+        for (const string& digest : digests)
+            out << digest << endl;
+        
+        out
+        << nodes.size() << " " << root << endl;
+        for (const node& n : nodes)
+        {
+            out
+            << n.item << " "
+            << n.inside << " " << n.outside << " "
+            << n.inside_min << " " << n.inside_max << " "
+            << n.outside_min << " " << n.outside_max << endl;
+        }
+        
+        if (out.fail())
+            throw io_exception("vp_tree::save(%s) failed", file);
+    };
+    
+    write_file_atomic(filename, write);
+}
+
+/* static */ vp_tree vp_tree::load(
+                                   const std::string& filename)
+{
+    APP_DEBUG_FNAME;
+    
+    if (!exist_file(filename))
+        throw io_exception("vp_tree::load(%s) failed, file does not exist", filename);
+    
+    ifstream in(filename);
+    vp_tree tree;
+    string header;
+    size_t count;
+    
+    getline(in, header);
+    getline(in, tree.metric);
+    in >> count;
+    in.ignore();
+    
+    if (in.fail() || header != FILE_HEADER)
+        throw io_exception("vp_tree::load(%s) failed, wrong file format", filename);
+    
+    tree.names.resize(count);
+    for (string& name : tree.names)
+        getline(in, name);
+    
+    in >> count;
+    in.ignore();
+    if (in.fail() || (count != 0 && count != tree.names.size()))
+        throw io_exception("vp_tree::load(%s) failed, wrong file format", filename);
+    
+    tree.digests.resize(count);
+    for (string& digest : tree.digests)
+        getline(in, digest);
+    
+    in >> count >> tree.root;
+    tree.nodes.resize(count);
+    for (node& n : tree.nodes)
+    {
+        in
+        >> n.item
+        >> n.inside >> n.outside
+        >> n.inside_min >> n.inside_max
+        >> n.outside_min >> n.outside_max;
+    }
+    
+    if (in.fail() || tree.root >= tree.nodes.size() ||
+        tree.nodes.size() != tree.names.size())
+        throw io_exception("vp_tree::load(%s) failed, wrong file format", filename);
+    
+    // children are built before their parent, so valid child index is lower
+    for (size_t i = 0; i < tree.nodes.size(); ++i)
+    {
+        const node& n = tree.nodes[i];
+        
+        if (n.item >= tree.names.size() ||
+            (n.inside != NONE && n.inside >= i) ||
+            (n.outside != NONE && n.outside >= i))
+            throw io_exception("vp_tree::load(%s) failed, wrong node %s", filename, i);
+    }
+    
+    return tree;
+}
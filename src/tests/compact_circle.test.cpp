@@ -71,6 +71,7 @@ void compact_circle_test::run()
 
     test_operations_success();
     test_operations_fail();
+    test_init();
 }
 
 
@@ -114,3 +115,32 @@ void compact_circle_test::test_operations_success()
 #undef circle
 }
 
+void compact_circle_test::test_init()
+{
+    APP_DEBUG_FNAME;
+
+    compact::circle c = create_valid_circle();
+    vector<point> points = c.init(10, 5);
+    double needed = compact::circle::min_circle_length(10, 5) + 2;
+
+    assert_equals(points.size(), 10);
+    // search stops within BASES_DISTANCE_PRECISION
+    assert_true(double_equals_precision(c.segment_length(), needed, 2));
+    assert_true(double_equals(distance(c.p1, c.centre), distance(c.p2, c.centre)));
+    // arc lies on the opposite side of `direction`
+    assert_true(c.centre.x < 0);
+
+    double step = distance(c.p1, points.front());
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        assert_true(double_equals(distance(points[i - 1], points[i]), step));
+        assert_true(double_equals(distance(points[i], c.centre), c.radius()));
+    }
+    assert_true(double_equals(distance(points.back(), c.p2), step));
+
+    // arc shorter than chord => almost straight line
+    c = create_valid_circle();
+    points = c.init(1, 5);
+    assert_equals(points.size(), 1);
+    assert_true(distance(points[0], {0, 0}) < 1);
+}
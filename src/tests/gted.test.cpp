@@ -23,6 +23,8 @@
 #include "gted.test.hpp"
 #include "gted.hpp"
 #include "mapping.hpp"
+#include "rted.hpp"
+#include "prepared_template.hpp"
 
 
 // == figure 4, str. 337
@@ -80,6 +82,7 @@ void gted_test::run()
     test_gted(rna_tree(BRACKETS21, LABELS21, "21"), rna_tree(BRACKETS22, LABELS22, "22"), 1);
     test_gted(rna_tree(BRACKETS1, LABELS1, "1"), rna_tree(BRACKETS21, LABELS21, "21"), 4);
     test_gted(rna_tree(BRACKETS1, LABELS1, "1"), rna_tree(BRACKETS22, LABELS22, "22"), 5);
+    test_prepared_template();
 }
 
 void gted_test::test_gted(
@@ -102,3 +105,37 @@ void gted_test::test_gted(
     assert_equals(m1, m2);
 }
 
+
+void gted_test::test_prepared_template()
+{
+    rna_tree templated(BRACKETS1, LABELS1, "1");
+    prepared_template templ(templated);
+
+    // one template used for more targets
+    for (const rna_tree& matched : {
+        rna_tree(BRACKETS21, LABELS21, "21"),
+        rna_tree(BRACKETS22, LABELS22, "22"),
+        rna_tree(BRACKETS1, LABELS1, "1")})
+    {
+        rted r(templated, matched);
+        r.run();
+
+        rted r_prepared = templ.get_rted(matched);
+        r_prepared.run();
+
+        assert_true(r.get_strategies() == r_prepared.get_strategies());
+
+        gted g = templ.get_gted(matched);
+        g.run(r_prepared.get_strategies());
+        mapping m = g.get_mapping();
+
+        assert_equals(g.get_distance(), m.distance);
+        assert_equals(templ.run_ted(matched).distance, m.distance);
+    }
+
+    // shared template is not copied
+    rna_tree_ptr shared = make_shared<rna_tree>(templated);
+    prepared_template shared_templ(shared);
+    assert_true(&shared_templ.get_rna() == shared.get());
+    assert_equals(shared_templ.run_ted(shared).distance, 0);
+}
@@ -0,0 +1,176 @@
+/*
+ * File: layout_session.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "layout_session.test.hpp"
+#include "layout_session.hpp"
+#include "radial_layout.hpp"
+
+using namespace std;
+
+// hairpin of pair (15, 23) is edited
+#define BRACKETS    "..((((....))..((.......))..))..((...)).."
+#define LABELS      "ACGUACGUACACGUACGUACACGUACGUACACGUACGUAC"
+
+layout_session_test::layout_session_test()
+    : test("layout_session")
+{ }
+
+/**
+ * positions of bases in order of sequence
+ */
+static vector<point> get_positions(
+                                   rna_tree rna)
+{
+    vector<point> out;
+
+    for (rna_tree::pre_post_order_iterator it = rna.begin_pre_post(); it != rna.end_pre_post(); ++it)
+        if (!rna_tree::is_root(it))
+            out.push_back(it->at(it.label_index()).p);
+
+    return out;
+}
+
+static bool operator==(
+                       const mapping& m1,
+                       const mapping& m2)
+{
+    if (m1.distance != m2.distance || m1.map.size() != m2.map.size())
+        return false;
+    for (size_t i = 0; i < m1.map.size(); ++i)
+        if (m1.map[i].from != m2.map[i].from || m1.map[i].to != m2.map[i].to)
+            return false;
+
+    return true;
+}
+
+void layout_session_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    // template is laid out by radial layout
+    rna_tree rna(BRACKETS, LABELS, "template");
+    radial_layout(rna).run();
+    templated = make_shared<rna_tree>(BRACKETS, LABELS, get_positions(rna), "template");
+
+    test_relabel();
+    test_hairpin_insertion();
+    test_new_pair();
+    test_exterior_loop();
+    test_no_change();
+}
+
+void layout_session_test::check_update(
+                                       const std::string& brackets,
+                                       const std::string& labels,
+                                       size_t begin,
+                                       size_t end,
+                                       size_t shift)
+{
+    APP_DEBUG_FNAME;
+
+    layout_session session(templated);
+    vector<point> before = get_positions(session.layout(make_shared<rna_tree>(BRACKETS, LABELS, "target")));
+    vector<point> after = get_positions(session.update(brackets, labels));
+
+    assert_equals(after.size(), before.size() + shift);
+    for (size_t i = 0; i < before.size(); ++i)
+    {
+        if (i < begin)
+        {
+            assert_equals(after[i], before[i]);
+        }
+        else if (i > end)
+        {
+            assert_equals(after[i + shift], before[i]);
+        }
+    }
+    for (const point& p : after)
+        assert_false(p.bad());
+
+    rna_tree_ptr target = make_shared<rna_tree>(brackets, labels, "target");
+    assert_true(session.get_mapping() == prepared_template(templated).run_ted(target));
+}
+
+void layout_session_test::test_relabel()
+{
+    APP_DEBUG_FNAME;
+
+    string labels = LABELS;
+    labels[19] = 'G';
+    check_update(BRACKETS, labels, 15, 23, 0);
+}
+
+void layout_session_test::test_hairpin_insertion()
+{
+    APP_DEBUG_FNAME;
+
+    string brackets = BRACKETS;
+    string labels = LABELS;
+    brackets.insert(19, "..");
+    labels.insert(19, "GA");
+    check_update(brackets, labels, 15, 23, 2);
+}
+
+void layout_session_test::test_new_pair()
+{
+    APP_DEBUG_FNAME;
+
+    string brackets = BRACKETS;
+    brackets.replace(16, 7, ".(...).");
+    check_update(brackets, LABELS, 15, 23, 0);
+}
+
+void layout_session_test::test_exterior_loop()
+{
+    APP_DEBUG_FNAME;
+
+    // no pair encloses the change, target is laid out from scratch
+    string labels = LABELS;
+    labels[0] = 'G';
+    rna_tree_ptr target = make_shared<rna_tree>(BRACKETS, labels, "target");
+
+    layout_session session(templated);
+    session.layout(make_shared<rna_tree>(BRACKETS, LABELS, "target"));
+    vector<point> updated = get_positions(session.update(BRACKETS, labels));
+
+    layout_session scratch(templated);
+    assert_true(get_positions(scratch.layout(target)) == updated);
+    assert_true(session.get_mapping() == prepared_template(templated).run_ted(target));
+}
+
+void layout_session_test::test_no_change()
+{
+    APP_DEBUG_FNAME;
+
+    layout_session session(templated);
+    const rna_tree& rna = session.layout(make_shared<rna_tree>(BRACKETS, LABELS, "target"));
+    vector<point> before = get_positions(rna);
+    mapping map = session.get_mapping();
+    // nodes are the same when layout is not computed again
+    const rna_pair_label* root = &*rna.begin();
+
+    assert_true(&session.update({10, 10, "", ""}) == &rna);
+    assert_true(&session.update(BRACKETS, LABELS) == &rna);
+    assert_true(&*rna.begin() == root);
+    assert_true(get_positions(rna) == before);
+    assert_true(session.get_mapping() == map);
+}
@@ -24,6 +24,8 @@
 #define TESTS
 #endif
 
+#include <random>
+
 #include "overlap_checks.hpp"
 #include "overlap_checks.test.hpp"
 
@@ -64,6 +66,11 @@ void overlap_checks_test::run()
             test_intersection(p1, p2, intersects[i++]);
 
     test_intersection({100, 0}, {10, -10}, true);
+
+    test_robust_intersection();
+    test_intersections();
+    test_count_overlaps();
+    test_run();
 }
 
 void overlap_checks_test::test_intersection(
@@ -83,3 +90,139 @@ void overlap_checks_test::test_intersection(
     assert_equals(!intersection.bad(), intersects);
 }
 
+
+void overlap_checks_test::test_count_overlaps()
+{
+    APP_DEBUG_FNAME;
+
+    // backbone (0,0) (10,0) (10,10) (5,10) (5,-5) (20,-5),
+    // edge #3 crosses edge #0 in (5,0)
+    vector<point> p = {{0, 0}, {10, 0}, {10, 10}, {5, 10}, {5, -5}, {20, -5}};
+    overlap_checks::edges vec;
+    for (size_t i = 0; i + 1 < p.size(); ++i)
+        vec.push_back({p[i], p[i + 1]});
+
+    overlap_checks::edge_grid grid(vec);
+
+    vector<size_t> candidates;
+    grid.candidates(vec[0], candidates);
+    sort(candidates.begin(), candidates.end());
+    assert_true(unique(candidates.begin(), candidates.end()) == candidates.end());
+    assert_true(contains(candidates, 3));
+
+    assert_equals(overlap_checks::count_overlaps(vec), 1);
+
+    // neighbours #2 and #4 share end points with #3
+    assert_equals(overlap_checks::count_overlaps(vec, grid, 3, {vec[3]}), 1);
+    assert_equals(overlap_checks::count_overlaps(vec, grid, 3, {{{5, 10}, {5, 5}}}), 0);
+    assert_equals(overlap_checks::count_overlaps(vec, grid, 3, {{{5, 10}, {15, 5}}}), 1);
+    // edges inside replaced range are not counted
+    assert_equals(overlap_checks::count_overlaps(vec, grid, 0, {vec[0], vec[1], vec[2], vec[3]}), 0);
+
+    // moved edge out of grid's original bounds
+    overlap_checks::edge moved = {{5, 10}, {100, 100}};
+    grid.move(3, vec[3], moved);
+    vec[3] = moved;
+    assert_equals(overlap_checks::count_overlaps(vec, grid, 0, {vec[0]}), 0);
+    assert_equals(overlap_checks::count_overlaps(vec, grid, 1, {{{10, 0}, {100, 120}}}), 1);
+}
+
+void overlap_checks_test::test_run()
+{
+    APP_DEBUG_FNAME;
+
+    // random backbone with many crossings, steps are also axis-parallel
+    minstd_rand random(1);
+    vector<point> p = {{0, 0}};
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        double alpha = (random() % 8) * 45 + (random() % 2 == 0 ? 0 : (random() % 1000) / 10.);
+        double length = 1 + (random() % 1000) / 100.;
+        p.push_back(move_point(p.back(), p.back() + rotate({0, 0}, alpha, 1), length));
+    }
+
+    overlap_checks::edges vec;
+    for (size_t i = 0; i + 1 < p.size(); ++i)
+        vec.push_back({p[i], p[i + 1]});
+
+    overlap_checks::overlaps expected = overlap_checks::get_overlaps(vec, vec);
+    overlap_checks::overlaps found = overlap_checks().run(vec);
+
+    assert_true(!expected.empty());
+    assert_equals(found.size(), expected.size());
+    for (size_t i = 0; i < found.size(); ++i)
+    {
+        assert_equals(found[i].centre, expected[i].centre);
+        assert_equals(found[i].radius, expected[i].radius);
+    }
+}
+
+void overlap_checks_test::test_robust_intersection()
+{
+    APP_DEBUG_FNAME;
+
+    overlap_checks::edge horizontal = {{0, 0}, {10, 0}};
+
+    // shared end point, T-junction, collinear overlap and near miss
+    assert_true(overlap_checks::intersection(horizontal, {{10, 0}, {10, 10}}).bad());
+    assert_equals(overlap_checks::intersection(horizontal, {{5, 0}, {5, 5}}), point(5, 0));
+    assert_equals(overlap_checks::intersection({{5, 5}, {5, 0}}, horizontal), point(5, 0));
+    assert_true(overlap_checks::intersection(horizontal, {{5, 0}, {15, 0}}).bad());
+    assert_true(overlap_checks::intersection(horizontal, {{5, 1e-9}, {5, 5}}).bad());
+    assert_false(overlap_checks::intersection(horizontal, {{5, -1e-9}, {5, 5}}).bad());
+
+    // end point one ulp below diagonal, sign is decided by exact arithmetic
+    overlap_checks::edge diagonal = {{0.5, 0.5}, {24, 24}};
+    point below = {12, nextafter(12., 0.)};
+    point p = overlap_checks::intersection(diagonal, {below, {12, 13}});
+    assert_false(p.bad());
+    assert_equals(p, point(12, 12));
+    assert_true(overlap_checks::intersection(diagonal, {below, {12, 0}}).bad());
+}
+
+void overlap_checks_test::test_intersections()
+{
+    APP_DEBUG_FNAME;
+
+    // points on small grid => many collinear, touching and crossing edges
+    minstd_rand random(1);
+    auto random_point = [&random]()
+    {
+        return point(random() % 8, random() % 8);
+    };
+
+    overlap_checks::edges_array batch;
+    vector<overlap_checks::edge> vec;
+    for (size_t i = 0; i < 500; ++i)
+    {
+        vec.push_back({random_point(), random_point()});
+        batch.push_back(vec.back());
+    }
+    assert_equals(batch.size(), vec.size());
+
+    vector<point> out;
+    size_t found = 0;
+    for (size_t i = 0; i < 20; ++i)
+    {
+        overlap_checks::edge e = {random_point(), random_point()};
+        overlap_checks::intersections(e, batch, out);
+
+        assert_equals(out.size(), vec.size());
+        for (size_t j = 0; j < vec.size(); ++j)
+        {
+            point p = overlap_checks::intersection(e, vec[j]);
+
+            assert_equals(out[j].bad(), p.bad());
+            if (!p.bad())
+            {
+                assert_true(out[j].x == p.x && out[j].y == p.y);
+                ++found;
+            }
+        }
+    }
+    assert_true(found != 0);
+
+    batch.clear();
+    overlap_checks::intersections(vec[0], batch, out);
+    assert_true(out.empty());
+}
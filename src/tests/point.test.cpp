@@ -20,6 +20,8 @@
  */
 
 
+#include <cfloat>
+
 #include "point.test.hpp"
 
 using namespace std;
@@ -49,6 +51,7 @@ void test_point::run()
     test_basics();
     test_operations();
     test_functions();
+    test_affine_transform();
 }
 
 void test_point::test_basics()
@@ -93,6 +96,27 @@ void test_point::test_functions()
 
     assert_true(lies_between(point_0_2, point_0_1, point_0_3));
     assert_false(lies_between(point_0_1, point_0_2, point_90deg));
+
+    assert_equals(orientation(point_0_0, point_1_0, point_1_1), 1);
+    assert_equals(orientation(point_0_0, point_1_1, point_1_0), -1);
+    assert_equals(orientation(point_0_1, point_0_2, point_0_3), 0);
+
+    // floating-point determinant has wrong sign or is not zero here,
+    // exact arithmetic has to decide
+    double next = nextafter(0.5, 1.);
+    assert_equals(orientation({0.5, 0.5}, {12, 12}, {24, 24}), 0);
+    assert_equals(orientation({next, 0.5}, {12, 12}, {24, 24}), -1);
+    assert_equals(orientation({0.5, next}, {12, 12}, {24, 24}), 1);
+    assert_equals(orientation({0.1, 0.1}, {0.3, 0.3}, {0.7, 0.7}), 0);
+    // cyclic permutation keeps sign
+    for (size_t i = 0; i < 64; ++i)
+    {
+        point p1(0.5 + i * DBL_EPSILON, 0.5), p2(12, 12), p3(24, 24);
+        int o = orientation(p1, p2, p3);
+        assert_equals(orientation(p2, p3, p1), o);
+        assert_equals(orientation(p3, p1, p2), o);
+        assert_equals(orientation(p2, p1, p3), -o);
+    }
 }
 
 void test_point::test_operations()
@@ -114,3 +138,29 @@ void test_point::test_operations()
     assert_fail(point_0_2 / point_0_1);
 }
 
+void test_point::test_affine_transform()
+{
+    APP_DEBUG_FNAME;
+
+    typedef affine_transform transform;
+
+    assert_true(transform().identity());
+    assert_equals(transform()(point_0_1), point_0_1);
+    assert_true(transform()(point_bad).bad());
+
+    assert_equals(transform::translation(point_0_2)(point_0_1), point_0_3);
+    assert_equals(transform::rotation(point_0_0, 90)(point_1_0), point_0_1);
+    assert_equals(transform::rotation(point_0_1, 180)(point_0_0), point_0_2);
+
+    // vertical mirror line
+    assert_equals(transform::reflection(point_0_0, point_0_1)(point_1_1), point(-1, 1));
+    assert_equals(transform::reflection(point_0_0, point_1_1)(point_1_0), point_0_1);
+
+    // translation applied first, then rotation
+    transform t = transform::rotation(point_0_0, 90) * transform::translation(point_1_0);
+    assert_equals(t(point_0_0), point_0_1);
+    assert_equals(t(point_m1_0), point_0_0);
+
+    transform m = transform::reflection(point_0_0, point_0_1);
+    assert_equals((m * m)(point(3, 4)), point(3, 4));
+}
@@ -0,0 +1,164 @@
+/*
+ * File: radial_layout.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "radial_layout.test.hpp"
+#include "radial_layout.hpp"
+#include "rna_tree.hpp"
+
+using namespace std;
+
+// multiloop, interior loop, bulge, hairpins and unpaired bases in exterior loop
+#define BRACKETS    "..((((...))..((..(((....)))))).)..(((...)))."
+// usual distances of radial_layout without template
+#define DEFAULT_PAIRS_DISTANCE          8.
+#define DEFAULT_PAIR_BASE_DISTANCE      20.
+
+radial_layout_test::radial_layout_test()
+    : test("radial_layout")
+{ }
+
+void radial_layout_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_default_distances();
+    test_template_distances();
+    test_tiny_loop();
+}
+
+/**
+ * centre of circle going through `p1`, `p2` and `p3`
+ */
+static point circumcentre(
+                          const point& p1,
+                          const point& p2,
+                          const point& p3)
+{
+    double d = 2 * (p1.x * (p2.y - p3.y) + p2.x * (p3.y - p1.y) + p3.x * (p1.y - p2.y));
+    double s1 = p1.x * p1.x + p1.y * p1.y;
+    double s2 = p2.x * p2.x + p2.y * p2.y;
+    double s3 = p3.x * p3.x + p3.y * p3.y;
+
+    return point((s1 * (p2.y - p3.y) + s2 * (p3.y - p1.y) + s3 * (p1.y - p2.y)) / d,
+                 (s1 * (p3.x - p2.x) + s2 * (p1.x - p3.x) + s3 * (p2.x - p1.x)) / d);
+}
+
+void radial_layout_test::check_layout(
+                                      rna_tree& rna,
+                                      double pairs_distance,
+                                      double pair_base_distance)
+{
+    APP_DEBUG_FNAME;
+
+    typedef rna_tree::iterator iterator;
+    typedef rna_tree::sibling_iterator sibling_iterator;
+
+    for (iterator it = rna.begin(); it != rna.end(); ++it)
+    {
+        if (rna_tree::is_root(it))
+            continue;
+
+        assert_true(it->initiated_points());
+        if (it->paired())
+            assert_true(double_equals(distance(it->at(0).p, it->at(1).p), pair_base_distance));
+    }
+
+    for (iterator it = rna.begin(); it != rna.end(); ++it)
+    {
+        if (rna_tree::is_leaf(it))
+            continue;
+
+        sibling_iterator ch = it.begin();
+        if (!rna_tree::is_root(it) && rna_tree::is_only_child(ch) && ch->paired())
+        {
+            assert_true(double_equals(distance(it->at(0).p, ch->at(0).p), pairs_distance));
+            assert_true(double_equals(distance(it->at(1).p, ch->at(1).p), pairs_distance));
+            continue;
+        }
+
+        // loop in order of the backbone, exterior loop has no closing pair
+        vector<point> loop;
+        if (!rna_tree::is_root(it))
+            loop.push_back(it->at(0).p);
+        for (ch = it.begin(); ch != it.end(); ++ch)
+        {
+            loop.push_back(ch->at(0).p);
+            if (ch->paired())
+                loop.push_back(ch->at(1).p);
+        }
+        if (!rna_tree::is_root(it))
+            loop.push_back(it->at(1).p);
+
+        if (loop.size() < 3)
+            continue;
+
+        point c = circumcentre(loop.front(), loop[loop.size() / 2], loop.back());
+        for (const point& p : loop)
+            assert_true(double_equals(distance(p, c), distance(loop.front(), c)));
+    }
+}
+
+void radial_layout_test::test_default_distances()
+{
+    APP_DEBUG_FNAME;
+
+    string brackets = BRACKETS;
+    rna_tree rna(brackets, string(brackets.size(), 'A'));
+
+    radial_layout(rna).run();
+    check_layout(rna, DEFAULT_PAIRS_DISTANCE, DEFAULT_PAIR_BASE_DISTANCE);
+}
+
+void radial_layout_test::test_template_distances()
+{
+    APP_DEBUG_FNAME;
+
+    rna_tree templated("((...))", "GGAAACC",
+                       {{0, 0}, {0, 6}, {-2, 12}, {5, 15}, {12, 12}, {10, 6}, {10, 0}});
+    assert_false(double_equals(templated.get_pairs_distance(), DEFAULT_PAIRS_DISTANCE));
+    assert_false(double_equals(templated.get_pair_base_distance(), DEFAULT_PAIR_BASE_DISTANCE));
+
+    string brackets = BRACKETS;
+    rna_tree rna(brackets, string(brackets.size(), 'A'));
+
+    radial_layout(rna, templated).run();
+    check_layout(rna, templated.get_pairs_distance(), templated.get_pair_base_distance());
+}
+
+void radial_layout_test::test_tiny_loop()
+{
+    APP_DEBUG_FNAME;
+
+    // single base can not close hairpin with pair 20 apart,
+    // angles of its loop are stretched
+    rna_tree rna("((.))", "GGACC");
+
+    radial_layout(rna).run();
+    check_layout(rna, DEFAULT_PAIRS_DISTANCE, DEFAULT_PAIR_BASE_DISTANCE);
+
+    rna_tree::iterator pair = ++ ++rna.begin();
+    point base = pair.begin()->at(0).p;
+
+    // base lies on the axis of the pair, away from the stem
+    assert_true(double_equals(distance(base, pair->at(0).p), distance(base, pair->at(1).p)));
+    assert_true(distance(base, rna.begin().begin()->at(0).p) > distance(base, pair->at(0).p));
+}
@@ -20,8 +20,12 @@
  */
 
 
+#include <thread>
+
 #include "rna_tree.test.hpp"
 #include "rna_tree.hpp"
+#include "rna_tree_flat.hpp"
+#include "dot_bracket.hpp"
 
 
 #define LABELS          "1234565731"
@@ -56,16 +60,123 @@ void rna_tree_test::run()
     assert_equals(rna.get_labels(it), "2");
     assert_equals(rna.get_brackets(it), ".");
 
+    const rna_pair_label* erased = &*it;
     rna.erase(it);
 
     assert_equals(rna.get_labels(), LABELS_DEL);
     assert_equals(rna.get_brackets(), BRACKETS_DEL);
 
     it = plusplus(rna.begin(), INDEX);
-    rna.insert(it, rna_pair_label("2"), 0);
+    it = rna.insert(it, rna_pair_label("2"), 0);
 
     assert_equals(rna.get_labels(), LABELS);
     assert_equals(rna.get_brackets(), BRACKETS);
+    // slot of erased node is reused
+    assert_true(&*it == erased);
+
+    // copy owns its nodes
+    rna_tree copy;
+    {
+        rna_tree other(BRACKETS, LABELS);
+        copy = other;
+    }
+    assert_equals(copy.get_labels(), LABELS);
+    assert_equals(copy.get_brackets(), BRACKETS);
+
+    // flat snapshot, BRACKETS "(.(.(.).))" in postorder:
+    //  0=2 1=4 2=6 3=5() 4=7 5=3() 6=1() 7=ROOT
+    rna_tree other(BRACKETS, LABELS);
+    auto flat = other.get_flat();
+    assert_equals(flat->size(), other.size());
+    assert_equals(flat->root(), 7);
+    assert_equals(flat->parent[flat->root()], rna_tree_flat::NONE);
+    assert_equals(flat->subtree_size[flat->root()], other.size());
+    assert_equals(flat->first_child[6], 0);
+    assert_equals(flat->next_sibling[0], 5);
+    assert_equals(flat->last_child[6], 5);
+    assert_equals(flat->leftmost_leaf[5], 1);
+    assert_equals(flat->depth[2], 4);
+    assert_true(flat->paired[3] && !flat->paired[4]);
+    assert_equals(flat->label_codes[2 * 5], '3');
+    assert_equals(flat->label_codes[2 * 5 + 1], '3');
+    // root twice, pairs twice, leafs once
+    assert_equals(flat->sequence.size(), 2 + string(BRACKETS).size());
+    assert_true(flat->sequence == vector<size_t>({14, 12, 0, 10, 2, 6, 4, 7, 8, 11, 13, 15}));
+    for (size_t i = 0; i < flat->size(); ++i)
+        assert_equals(flat->ids[i], i);
+
+    // snapshot is cached until tree is changed
+    assert_true(other.get_flat() == flat);
+    other.erase(plusplus(other.begin(), INDEX));
+    assert_true(!(other.get_flat() == flat));
+    assert_equals(other.get_flat()->size(), other.size());
+
+    // ids are owned by trees, trees can be built and renumbered concurrently
+    vector<char> ordered(4, false);
+    vector<thread> threads;
+    for (size_t t = 0; t < ordered.size(); ++t)
+        threads.emplace_back([&ordered, t]() {
+            bool ok = true;
+            for (size_t i = 0; i < 100; ++i)
+            {
+                rna_tree rna(BRACKETS, LABELS);
+                rna.erase(plusplus(rna.begin(), INDEX));
+                rna.set_postorder_ids();
+                ok = ok && rna.is_ordered_postorder();
+            }
+            ordered[t] = ok;
+        });
+    for (thread& t : threads)
+        t.join();
+    for (char ok : ordered)
+        assert_true(ok);
+
+    // labels are stored inline, root ends use side table
+    rna_pair_label root = rna_pair_label("5'") + rna_pair_label("3'");
+    assert_equals(root.at(0).label(), "5'");
+    assert_equals(root.at(1).label(), "3'");
+    assert_equals(root.at(1).first_char(), '3');
+    assert_equals(rna_pair_label('A').at(0).label(), "A");
+    assert_equals(rna_pair_label("").at(0).label(), "");
+    assert_fail(rna_pair_label("AC"));
+
+    child_bitset remake;
+    assert_true(remake.empty());
+    remake.insert(3);
+    remake.insert(3);
+    remake.insert(130);
+    assert_true(remake.contains(3) && remake.contains(130));
+    assert_true(!remake.contains(4) && !remake.contains(66));
+    assert_equals(remake.max(), 130);
+    remake.clear();
+    assert_true(remake.empty());
+
+    // dot-bracket parser, pseudoknots are unpaired
+    dot_bracket structure = dot_bracket::parse(" (.[(.)]).\n");
+    assert_equals(structure.size(), 9);
+    assert_equals(structure.pairs[0], 7);
+    assert_equals(structure.pairs[3], 5);
+    assert_equals(structure.pairs[2], dot_bracket::NONE);
+    assert_true(structure.is_opening(0) && structure.is_closing(7));
+    assert_fail(dot_bracket::parse("(.))"));
+    assert_fail(dot_bracket::parse("((.)"));
+    assert_fail(dot_bracket::parse("(. .)"));
+    assert_fail(dot_bracket::parse("(.x)"));
+    assert_true(dot_bracket::is_structure_line("..{"));
+    assert_true(!dot_bracket::is_structure_line("ACGU"));
+    assert_fail(rna_tree("(.))", "ACGU"));
+    assert_equals(rna_tree(" " BRACKETS "\n", " " LABELS "\n").get_labels(), LABELS);
+
+    // batch erase, children of erased pair B-E are checked too
+    rna_tree edited("((..).)", "ABCDEFG");
+    iterator pair = rna_tree::first_child(edited.begin());
+    plusplus(pair, 1)->status = rna_pair_label::deleted;
+    plusplus(pair, 3)->status = rna_pair_label::deleted;
+    edited.erase_deleted();
+    assert_equals(edited.get_labels(), "ACFG");
+    assert_equals(edited.get_brackets(), "(..)");
+    assert_true(pair->remake_ids.contains(0) && pair->remake_ids.contains(1));
+    assert_equals(pair->remake_ids.max(), 1);
 }
 
 
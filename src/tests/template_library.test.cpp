@@ -0,0 +1,361 @@
+/*
+ * File: template_library.test.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+
+#include <mutex>
+
+#include "template_library.test.hpp"
+#include "template_library.hpp"
+#include "prepared_template.hpp"
+#include "utils.hpp"
+#include "vp_tree.hpp"
+#include "distance_matrix.hpp"
+#include "app.hpp"
+
+#define TEST_DIRECTORY "/tmp/template-library-test"
+#define TEST_INDEX_FILE "/tmp/template-library-test.index"
+#define TEST_MATRIX_FILE "/tmp/template-library-test.matrix"
+#define TEST_MANIFEST_FILE "/tmp/template-library-test.manifest"
+
+using namespace std;
+
+template_library_test::template_library_test()
+    : test("template_library")
+{ }
+
+void template_library_test::run()
+{
+    APP_DEBUG_FNAME;
+
+    test_lower_bounds();
+    test_find_best();
+    test_vp_tree();
+    test_distance_matrix();
+    test_shards();
+}
+
+void template_library_test::test_lower_bounds()
+{
+    vector<rna_tree> trees = create_trees();
+
+    for (rna_tree& t1 : trees)
+    {
+        for (rna_tree& t2 : trees)
+        {
+            tree_profile p1(t1), p2(t2);
+            size_t distance = prepared_template(t1).run_ted(t2).distance;
+
+            assert_true(size_lower_bound(p1, p2) <= distance);
+            assert_true(histogram_lower_bound(p1, p2) <= distance);
+            assert_true(euler_lower_bound(p1, p2, distance + 1) <= distance);
+            // bound is cut at limit
+            assert_true(euler_lower_bound(p1, p2, 1) <= 1);
+        }
+    }
+
+    rna_tree t1("((..))", "GGAACC");
+    rna_tree t2("((....))", "GGAAAACC");
+    assert_equals(size_lower_bound(tree_profile(t1), tree_profile(t2)), 2);
+    assert_equals(euler_lower_bound(tree_profile(t1), tree_profile(t2), 10), 2);
+}
+
+void template_library_test::test_find_best()
+{
+    vector<rna_tree> trees = create_trees();
+
+    create_directory(TEST_DIRECTORY);
+    for (size_t i = 0; i < trees.size(); ++i)
+    {
+        string name = TEST_DIRECTORY "/template" + to_string(i);
+        string labels = trees[i].get_labels();
+        ostringstream image;
+
+        image << "<structure>" << endl;
+        for (size_t j = 0; j < labels.size(); ++j)
+            image << "<point x=\"" << 10 * j << "\" y=\"0\" b=\"" << labels[j] << "\"/>" << endl;
+        image << "</structure>" << endl;
+
+        write_file(name + ".fasta", ">template" + to_string(i) + "\n" + labels + "\n" + trees[i].get_brackets() + "\n");
+        write_file(name + ".xml", image.str());
+    }
+    // fasta without image is not indexed
+    write_file(TEST_DIRECTORY "/no_image.fasta", ">no_image\nAAA\n...\n");
+
+    template_library library(TEST_DIRECTORY);
+    assert_equals(library.get_entries().size(), trees.size());
+
+    for (const rna_tree& rna : trees)
+    {
+        rna_tree_ptr matched = make_shared<rna_tree>(rna);
+        size_t minimum = SIZE_MAX;
+        for (const auto& e : library.get_entries())
+            minimum = min(minimum, prepared_template(e.rna).run_ted(matched).distance);
+
+        // top == size -> search is exact
+        auto res = library.find_best(matched, trees.size());
+        assert_equals(res.map.distance, minimum);
+        assert_equals(res.map.distance, 0);
+        assert_true(res.ted_runs + res.pruned_by_histograms + res.pruned_by_euler == trees.size());
+        assert_equals(res.skipped_by_top, 0);
+
+        rna_tree_ptr templated = library.create_templated(res.index);
+        assert_equals(templated->get_brackets(), matched->get_brackets());
+    }
+
+    // templates cut off by `top` are not counted as pruned by bounds
+    rna_tree_ptr matched = make_shared<rna_tree>("(((...)).(...))", "GGGAAACCAGAAACC");
+    tree_profile profile(*matched);
+    auto res = library.find_best(matched, 1);
+    size_t below = 0;
+    for (size_t i = 0; i < trees.size(); ++i)
+    {
+        const tree_profile& p = library.get_entries()[i].profile;
+        if (i != res.index &&
+            max(size_lower_bound(p, profile), histogram_lower_bound(p, profile)) < res.map.distance)
+            ++below;
+    }
+    assert_equals(res.ted_runs, 1);
+    assert_equals(res.skipped_by_top, below);
+    assert_true(res.skipped_by_top != 0);
+    assert_equals(res.ted_runs + res.pruned_by_histograms + res.skipped_by_top, trees.size());
+
+    vp_tree index = library.create_index();
+    assert_true(library.is_valid_index(index));
+    assert_true(!library.is_valid_index(vp_tree()));
+    for (const rna_tree& rna : trees)
+    {
+        auto res = library.find_best(make_shared<rna_tree>(rna), index);
+        assert_equals(res.map.distance, 0);
+        assert_equals(res.ted_runs + res.pruned_by_index, trees.size());
+    }
+
+    // template edited under the same name invalidates index
+    string fasta = TEST_DIRECTORY "/template0.fasta";
+    string original = read_file(fasta);
+    write_file(fasta, ">template0\nGGAAACC\n((...))\n");
+    assert_false(template_library(TEST_DIRECTORY).is_valid_index(index));
+    write_file(fasta, original);
+    assert_true(template_library(TEST_DIRECTORY).is_valid_index(index));
+}
+
+void template_library_test::test_vp_tree()
+{
+    // points on line, metric |i - j|
+    vector<size_t> values = {1, 5, 9, 10, 14, 20, 21, 35, 50, 51, 60, 80, 81, 82, 100, 130};
+    vector<string> names;
+    for (size_t v : values)
+        names.push_back("point " + to_string(v));
+
+    auto absdiff = [](size_t a, size_t b) {
+        return a > b ? a - b : b - a;
+    };
+    vector<string> digests;
+    for (size_t v : values)
+        digests.push_back(hash_string(to_string(v)));
+    vp_tree tree(names, "line", [&](size_t i, size_t j) {
+        return absdiff(values[i], values[j]);
+    }, digests);
+
+    tree.save(TEST_INDEX_FILE);
+    vp_tree loaded = vp_tree::load(TEST_INDEX_FILE);
+    assert_true(loaded.get_names() == names);
+    assert_true(loaded.get_digests() == digests);
+    assert_equals(loaded.get_metric(), "line");
+
+    size_t evaluations = 0;
+    for (size_t query = 0; query <= 140; query += 3)
+    {
+        size_t minimum = SIZE_MAX;
+        for (size_t v : values)
+            minimum = min(minimum, absdiff(v, query));
+
+        for (const vp_tree* t : {&tree, &loaded})
+        {
+            auto res = t->find_nearest([&](size_t i) {
+                return absdiff(values[i], query);
+            });
+            assert_equals(res.distance, minimum);
+            assert_equals(absdiff(values[res.item], query), minimum);
+            evaluations += res.evaluations;
+        }
+    }
+    // some items have to be pruned
+    assert_true(evaluations < 2 * 47 * values.size());
+
+    // root is saved last, its child index points out of built nodes
+    string saved = read_file(TEST_INDEX_FILE);
+    size_t root_line = saved.rfind('\n', saved.size() - 2) + 1;
+    size_t inside = saved.find(' ', root_line) + 1;
+    saved.replace(inside, saved.find(' ', inside) - inside, "99");
+    write_file(TEST_INDEX_FILE, saved);
+    assert_fail(vp_tree::load(TEST_INDEX_FILE));
+
+    write_file(TEST_INDEX_FILE, "XYZ");
+    assert_fail(vp_tree::load(TEST_INDEX_FILE));
+}
+
+void template_library_test::test_distance_matrix()
+{
+    vector<rna_tree> trees = create_trees();
+    vector<string> names;
+    for (const rna_tree& rna : trees)
+        names.push_back(rna.name());
+
+    vector<vector<size_t>> mapped(trees.size(), vector<size_t>(trees.size(), SIZE_MAX));
+    mutex mapped_mutex;
+    auto on_mapping = [&](size_t i, size_t j, const mapping& map) {
+        lock_guard<mutex> lock(mapped_mutex);
+        mapped[i][j] = map.distance;
+        // reversed mapping has to be valid mapping from i to j
+        assert_true(trees[i].size() + map.get_to_insert().size() ==
+                    trees[j].size() + map.get_to_remove().size());
+    };
+
+    distance_matrix matrix(trees, names);
+    matrix.run(3, on_mapping);
+
+    auto distances = matrix.get_distances();
+    for (size_t i = 0; i < trees.size(); ++i)
+    {
+        assert_equals(distances[i][i], 0);
+        for (size_t j = 0; j < trees.size(); ++j)
+        {
+            if (i == j)
+                continue;
+            assert_equals(distances[i][j], prepared_template(trees[i]).run_ted(trees[j]).distance);
+            assert_equals(mapped[i][j], distances[i][j]);
+        }
+    }
+
+    mapping map = prepared_template(trees[0]).run_ted(trees[3]);
+    mapping reversed = map.reverse().reverse();
+    assert_equals(reversed.distance, map.distance);
+    assert_true(reversed.map.size() == map.map.size());
+    for (size_t i = 0; i < map.map.size(); ++i)
+        assert_true(!(map.map[i] < reversed.map[i]) && !(reversed.map[i] < map.map[i]));
+}
+
+void template_library_test::test_shards()
+{
+    vector<rna_tree> trees = create_trees();
+    vector<string> names;
+    for (const rna_tree& rna : trees)
+        names.push_back(rna.name());
+
+    shard part = shard::parse("1/3");
+    assert_equals(part.index, 1);
+    assert_equals(part.count, 3);
+    assert_true(part.contains(4) && !part.contains(3));
+    assert_fail(shard::parse("3/3"));
+    assert_fail(shard::parse("1"));
+
+    distance_matrix whole(trees, names);
+    whole.run(1);
+    whole.save(TEST_MATRIX_FILE);
+    string expected = read_file(TEST_MATRIX_FILE);
+
+    // every shard writes only its partial output
+    for (part.index = 0; part.index < part.count; ++part.index)
+    {
+        distance_matrix matrix(trees, names);
+        matrix.run(2, nullptr, part);
+        matrix.save_partial(TEST_MATRIX_FILE);
+    }
+    remove(TEST_MATRIX_FILE);
+
+    distance_matrix merged = distance_matrix::merge(TEST_MATRIX_FILE, part.count);
+    merged.save(TEST_MATRIX_FILE);
+    assert_equals(read_file(TEST_MATRIX_FILE), expected);
+    assert_true(merged.get_distances() == whole.get_distances());
+
+    // missing shard output
+    assert_fail((distance_matrix::merge(TEST_MATRIX_FILE, 2)));
+
+    // malformed distance of the last record is reported as io_exception
+    for (string value : {"x", "-1", "", "1x", "99999999999999999999999"})
+    {
+        for (part.index = 0; part.index < part.count; ++part.index)
+        {
+            distance_matrix matrix(trees, names);
+            matrix.run(1, nullptr, part);
+            matrix.save_partial(TEST_MATRIX_FILE);
+        }
+        part.index = 0;
+        string file = part.get_filename(TEST_MATRIX_FILE);
+        string text = read_file(file);
+        size_t end = text.size() - 1;
+        size_t begin = text.find_last_not_of("0123456789", end - 1) + 1;
+        text.replace(begin, end - begin, value);
+        write_file(file, text);
+
+        bool io_error = false;
+        try
+        {
+            distance_matrix::merge(TEST_MATRIX_FILE, part.count);
+        }
+        catch (const io_exception&)
+        {
+            io_error = true;
+        }
+        assert_true(io_error);
+    }
+
+    // malformed target index of layout manifest fails merging, not the process
+    for (string value : {"x", "-1", "", "7", "99999999999999999999999"})
+    {
+        for (part.index = 0; part.index < part.count; ++part.index)
+        {
+            shard_output output;
+            output.type = "layout-manifest";
+            output.part = part;
+            output.names = names;
+            for (size_t k = part.index; k < names.size(); k += part.count)
+                output.records.push_back({to_string(k), names[k], names[0], "0"});
+            if (part.index == 0)
+                output.records.back()[0] = value;
+            output.save(part.get_filename(TEST_MANIFEST_FILE));
+        }
+
+        bool app_error = false;
+        try
+        {
+            app().run({"traveler", "--merge-shards", to_string(part.count), TEST_MANIFEST_FILE});
+        }
+        catch (const aplication_error&)
+        {
+            app_error = true;
+        }
+        assert_true(app_error);
+    }
+}
+
+/* static */ vector<rna_tree> template_library_test::create_trees()
+{
+    return {
+        rna_tree("((..))", "GGAACC", "hairpin"),
+        rna_tree("((....))", "GGAAAACC", "long_hairpin"),
+        rna_tree("(.(..).)", "GAGAACAC", "interior"),
+        rna_tree("((..)(..))", "GGAACGAACC", "multi"),
+        rna_tree("..((..))..(.)", "AAGGAACCAAGAC", "two_branches"),
+        rna_tree("(((..).(..)))", "GGGAACAGAACCC", "nested"),
+    };
+}
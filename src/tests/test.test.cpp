@@ -30,6 +30,9 @@
 #include "overlap_checks.test.hpp"
 #include "utils.test.hpp"
 #include "mprintf.test.hpp"
+#include "template_library.test.hpp"
+#include "radial_layout.test.hpp"
+#include "layout_session.test.hpp"
 
 using namespace std;
 
@@ -47,6 +50,9 @@ using namespace std;
         new overlap_checks_test(),
         new utils_test(),
         new mprinf_test(),
+        new template_library_test(),
+        new radial_layout_test(),
+        new layout_session_test(),
     };
 
     for (test* t : vec)
@@ -47,6 +47,7 @@ void utils_test::run()
     test_exist_file();
     test_io();
     test_read_fasta_file();
+    test_write_file_atomic();
 }
 
 void utils_test::test_exist_file()
@@ -78,6 +79,22 @@ void utils_test::test_read_fasta_file()
     assert_fail(read_fasta_file(TEST_FILE));
 }
 
+void utils_test::test_write_file_atomic()
+{
+    string text = create_fasta_text();
+    write_file_atomic(TEST_FILE, [&text](const string& tmp) {
+        write_file(tmp, text);
+    });
+    assert_equals(read_file(TEST_FILE), text);
+
+    // failed write keeps previous content
+    assert_fail(write_file_atomic(TEST_FILE, [](const string& tmp) {
+        write_file(tmp, "XYZ");
+        throw io_exception("write failed");
+    }));
+    assert_equals(read_file(TEST_FILE), text);
+}
+
 fasta utils_test::create_fasta()
 {
     fasta f;
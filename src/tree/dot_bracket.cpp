@@ -0,0 +1,122 @@
+/*
+ * File: dot_bracket.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "dot_bracket.hpp"
+
+#define UNPAIRED_CHARACTERS     ".[{}]"
+#define WHITESPACE_CHARACTERS   " \t\n\r\f\v"
+
+using namespace std;
+
+typedef dot_bracket::char_class char_class;
+
+/* static */ const size_t dot_bracket::NONE;
+
+static const char_class* get_classes();
+
+/* static */ dot_bracket dot_bracket::parse(
+                                            const std::string& brackets)
+{
+    const char_class* classes = get_classes();
+    const size_t n = brackets.size();
+    size_t begin = 0;
+    size_t end = n;
+    dot_bracket out;
+    vector<size_t> opened;
+    
+    while (begin < end && classes[(unsigned char)brackets[begin]] == whitespace)
+        ++begin;
+    while (end > begin && classes[(unsigned char)brackets[end - 1]] == whitespace)
+        --end;
+    
+    out.pairs.resize(end - begin, NONE);
+    
+    for (size_t i = begin; i < end; ++i)
+    {
+        char ch = brackets[i];
+        size_t index = i - begin;
+        
+        switch (classes[(unsigned char)ch])
+        {
+            case unpaired:
+                break;
+            case opening:
+                opened.push_back(index);
+                break;
+            case closing:
+                if (opened.empty())
+                    throw wrong_argument_exception("Unbalanced dot-bracket structure, ')' at index %s is not opened", index);
+                out.pairs[index] = opened.back();
+                out.pairs[opened.back()] = index;
+                opened.pop_back();
+                break;
+            default:
+                throw wrong_argument_exception("Invalid dot-bracket character '%s' at index %s", ch, index);
+        }
+    }
+    
+    if (!opened.empty())
+        throw wrong_argument_exception("Unbalanced dot-bracket structure, '(' at index %s is not closed", opened.back());
+    
+    return out;
+}
+
+/* static */ char_class dot_bracket::get_class(
+                                               char ch)
+{
+    return get_classes()[(unsigned char)ch];
+}
+
+/* static */ bool dot_bracket::is_structure_line(
+                                                 const std::string& line)
+{
+    const char_class* classes = get_classes();
+    
+    for (char ch : line)
+        if (classes[(unsigned char)ch] >= unpaired)
+            return true;
+    return false;
+}
+
+/* local */ const char_class* get_classes()
+{
+    struct table
+    {
+        table()
+        {
+            for (char_class& c : classes)
+                c = dot_bracket::invalid;
+            for (const char* ch = WHITESPACE_CHARACTERS; *ch != 0; ++ch)
+                classes[(unsigned char)*ch] = dot_bracket::whitespace;
+            for (const char* ch = UNPAIRED_CHARACTERS; *ch != 0; ++ch)
+                classes[(unsigned char)*ch] = dot_bracket::unpaired;
+            classes[(unsigned char)'('] = dot_bracket::opening;
+            classes[(unsigned char)')'] = dot_bracket::closing;
+        }
+        
+        char_class classes[256];
+    };
+    // initialization of local static is thread-safe
+    static const table t;
+    
+    return t.classes;
+}
@@ -23,22 +23,22 @@
 #include <cfloat>
 
 #include "rna_tree.hpp"
+#include "rna_tree_flat.hpp"
+
+#define WHITESPACES " \t\n\r\f\v"
 
 using namespace std;
 
 inline static std::vector<rna_pair_label> convert(
                                                   const std::string& labels);
 
-inline static std::string trim(
-                               std::string s);
-
 
 rna_tree::rna_tree(
                    const std::string& _brackets,
                    const std::string& _labels,
                    const std::string& _name)
 : tree_base<rna_pair_label>(
-                            trim(_brackets), convert(trim(_labels))), _name(_name)
+                            _brackets, convert(_labels)), _name(_name)
 {
     set_postorder_ids();
     distances = {0xBADF00D, 0xBADF00D, 0xBADF00D};
@@ -69,12 +69,18 @@ void rna_tree::set_name(
 /* inline, local */ std::vector<rna_pair_label> convert(
                                                         const std::string& labels)
 {
+    // surrounding whitespaces are skipped, as in dot_bracket::parse()
+    size_t begin = labels.find_first_not_of(WHITESPACES);
+    size_t end = labels.find_last_not_of(WHITESPACES) + 1;
     vector<rna_pair_label> vec;
     
-    vec.reserve(labels.size());
+    if (begin == string::npos)
+        return vec;
     
-    for (size_t i = 0; i < labels.size(); ++i)
-        vec.emplace_back(labels.substr(i, 1));
+    vec.reserve(end - begin);
+    
+    for (size_t i = begin; i < end; ++i)
+        vec.emplace_back(labels[i]);
     
     return vec;
 }
@@ -97,6 +103,7 @@ void rna_tree::update_points(
     assert(i == points.size() && ++pre_post_order_iterator(it) == end_pre_post());
     
     update_ends_in_rna(*this);
+    invalidate_flat();
 }
 
 //highlights 5' and 3' end
@@ -149,9 +156,9 @@ void update_ends_in_rna(
     
     
     
-    root->at(0).label = "5'";
+    root->at(0).set_label("5'");
     
-    root->at(1).label = "3'";
+    root->at(1).set_label("3'");
     
     INFO("RNA ends (3', 5') are updated");
 }
@@ -171,10 +178,40 @@ rna_tree::sibling_iterator rna_tree::erase(
     assert(is_leaf(del));
     _tree.erase(del);
     --_size;
+    invalidate_flat();
     
     return sib;
 }
 
+void rna_tree::erase_deleted()
+{
+    APP_DEBUG_FNAME;
+    
+    for (iterator it = begin(); it != end(); ++it)
+    {
+        // position of `ch` between children remaining in `it`
+        size_t index = 0;
+        
+        for (sibling_iterator ch = it.begin(); ch != it.end();)
+        {
+            if (is(ch, rna_pair_label::deleted))
+            {
+                /*
+                 * Set Information for the drawing algorithm that descendants will need to be moved
+                 * and siblings (loop) will need to be replaced on the circle
+                 */
+                it->remake_ids.insert(index);
+                ch = erase(ch);
+            }
+            else
+            {
+                ++index;
+                ++ch;
+            }
+        }
+    }
+}
+
 rna_tree::sibling_iterator rna_tree::insert(
                                             sibling_iterator sib,
                                             rna_pair_label lbl,
@@ -194,15 +231,42 @@ rna_tree::sibling_iterator rna_tree::insert(
     
     _tree.reparent(pos, beg, end);
     ++_size;
+    invalidate_flat();
     
     return pos;
 }
 
+void rna_tree::set_postorder_ids()
+{
+    tree_base<rna_pair_label>::set_postorder_ids();
+    invalidate_flat();
+}
+
 std::string rna_tree::name() const
 {
     return _name;
 }
 
+std::shared_ptr<const rna_tree_flat> rna_tree::get_flat() const
+{
+    // trees are shared between threads read-only (distance_matrix),
+    // cache is set atomically, concurrent callers can build equal snapshots
+    shared_ptr<const rna_tree_flat> snapshot = atomic_load(&flat);
+    
+    if (snapshot == nullptr)
+    {
+        snapshot = make_shared<const rna_tree_flat>(*this);
+        atomic_store(&flat, snapshot);
+    }
+    
+    return snapshot;
+}
+
+void rna_tree::invalidate_flat()
+{
+    atomic_store(&flat, shared_ptr<const rna_tree_flat>());
+}
+
 
 /* static */ std::string rna_tree::get_labels(
                                               const iterator& root)
@@ -211,7 +275,7 @@ std::string rna_tree::name() const
     
     auto f =
     [&out](const pre_post_order_iterator& iter) {
-        out << iter->at(iter.label_index()).label;
+        out << iter->at(iter.label_index()).label();
     };
     
     for_each_in_subtree(root, f);
@@ -222,7 +286,7 @@ std::string rna_tree::name() const
 std::string rna_tree::get_labels() const
 {
     ostringstream out;
-    iterator root = begin();
+    iterator root = _tree.begin();
     for (sibling_iterator ch = root.begin(); ch != root.end(); ++ch)
         out << get_labels(ch);
     
@@ -252,7 +316,7 @@ std::string rna_tree::get_labels() const
 std::string rna_tree::get_brackets() const
 {
     ostringstream out;
-    iterator root = begin();
+    iterator root = _tree.begin();
     for (sibling_iterator ch = root.begin(); ch != root.end(); ++ch)
         out << get_brackets(ch);
     
@@ -264,7 +328,7 @@ bool rna_tree::correct_pairing() const
 {
     APP_DEBUG_FNAME;
     
-    for (iterator it = begin(); it != end(); ++it)
+    for (const_iterator it = begin(); it != end(); ++it)
     {
         // if is leaf and is paired..
         if (is_leaf(it) == it->paired())
@@ -456,23 +520,6 @@ point rna_tree::bottom_left_corner(
 }
 
 
-/* inline, local */ std::string trim(
-                                     std::string s)
-{
-#define WHITESPACES " \t\n\r\f\v"
-    size_t pos;
-    
-    pos = s.find_first_not_of(WHITESPACES);
-    if (pos != s.npos)
-        s.erase(0, pos);
-    pos = s.find_last_not_of(WHITESPACES);
-    if (pos != s.npos)
-        s.erase(pos + 1);
-    
-    return s;
-}
-
-
 /* static */ point rna_tree::base_pair_edge_point(
                                                   point from,
                                                   point to)
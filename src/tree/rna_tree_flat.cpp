@@ -0,0 +1,117 @@
+/*
+ * File: rna_tree_flat.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <unordered_map>
+
+#include "rna_tree_flat.hpp"
+
+using namespace std;
+
+/* static */ const size_t rna_tree_flat::NONE;
+
+rna_tree_flat::rna_tree_flat(
+                             const rna_tree& rna)
+{
+    APP_DEBUG_FNAME;
+    
+    typedef rna_tree::const_post_order_iterator const_post_order_iterator;
+    
+    const size_t n = rna.size();
+    unordered_map<const void*, size_t> index;
+    
+    ids.reserve(n);
+    index.reserve(n);
+    for (const_post_order_iterator it = rna.begin_post(); it != rna.end_post(); ++it)
+    {
+        index[it.node] = ids.size();
+        ids.push_back(::id(it));
+    }
+    assert(ids.size() == n);
+    
+    for (auto array : {&parent, &first_child, &last_child, &next_sibling,
+        &subtree_size, &leftmost_leaf, &depth})
+        array->resize(n, NONE);
+    paired.resize(n, false);
+    initiated.resize(n, false);
+    label_codes.resize(2 * n, 0);
+    x.resize(2 * n, 0);
+    y.resize(2 * n, 0);
+    
+    size_t i = 0;
+    for (const_post_order_iterator it = rna.begin_post(); it != rna.end_post(); ++it, ++i)
+    {
+        size_t previous = NONE;
+        
+        subtree_size[i] = 1;
+        for (auto ch = it.node->first_child; ch != nullptr; ch = ch->next_sibling)
+        {
+            size_t child = index[ch];
+            
+            parent[child] = i;
+            subtree_size[i] += subtree_size[child];
+            if (previous == NONE)
+                first_child[i] = child;
+            else
+                next_sibling[previous] = child;
+            previous = child;
+        }
+        last_child[i] = previous;
+        leftmost_leaf[i] = is_leaf(i) ? i : leftmost_leaf[first_child[i]];
+        
+        paired[i] = it->paired();
+        initiated[i] = it->initiated_points();
+        for (size_t k = 0; k < it->size(); ++k)
+        {
+            const rna_label& label = it->at(k);
+            
+            label_codes[2 * i + k] = label.first_char();
+            x[2 * i + k] = label.p.x;
+            y[2 * i + k] = label.p.y;
+        }
+    }
+    
+    // parents are after their children in postorder
+    for (i = n; i-- != 0;)
+        depth[i] = parent[i] == NONE ? 0 : depth[parent[i]] + 1;
+    
+    // order of rna_tree::pre_post_order_iterator: node opens before its
+    // children and closes after them (with 2nd base if paired), leaf once
+    sequence.reserve(2 * n);
+    for (i = root(); ; i = next_sibling[i])
+    {
+        // down to leftmost leaf
+        for (; ; i = first_child[i])
+        {
+            sequence.push_back(2 * i);
+            if (is_leaf(i))
+                break;
+        }
+        // up while there is no next sibling
+        while (next_sibling[i] == NONE && parent[i] != NONE)
+        {
+            i = parent[i];
+            sequence.push_back(2 * i + (paired[i] ? 1 : 0));
+        }
+        if (next_sibling[i] == NONE)
+            break;
+    }
+}
@@ -26,10 +26,108 @@
 using namespace std;
 
 
+/**
+ * side table of labels longer than one character, index is stored as base
+ * code; codes are control characters so they never clash with real bases
+ */
+static const char* const long_labels[] = {"", "5'", "3'", "ROOT"};
+#define LONG_LABELS_SIZE (sizeof(long_labels) / sizeof(long_labels[0]))
+
 bool rna_label::operator==(
                            const rna_label& other) const
 {
-    return label == other.label;
+    return base == other.base;
+}
+
+std::string rna_label::label() const
+{
+    if ((unsigned char)base < LONG_LABELS_SIZE)
+        return long_labels[(unsigned char)base];
+    return string(1, base);
+}
+
+char rna_label::first_char() const
+{
+    if ((unsigned char)base < LONG_LABELS_SIZE)
+        return long_labels[(unsigned char)base][0];
+    return base;
+}
+
+void rna_label::set_label(
+                          const std::string& s)
+{
+    if (s.size() == 1 && (unsigned char)s[0] >= LONG_LABELS_SIZE)
+    {
+        base = s[0];
+        return;
+    }
+    for (size_t i = 0; i < LONG_LABELS_SIZE; ++i)
+        if (s == long_labels[i])
+        {
+            base = (char)i;
+            return;
+        }
+    
+    throw wrong_argument_exception("Label '%s' can not be stored in rna_label", s);
+}
+
+
+
+
+void child_bitset::insert(
+                          size_t index)
+{
+    if (index < 64)
+    {
+        bits |= uint64_t(1) << index;
+        return;
+    }
+    
+    index -= 64;
+    if (overflow.size() <= index / 64)
+        overflow.resize(index / 64 + 1, 0);
+    overflow[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+bool child_bitset::contains(
+                            size_t index) const
+{
+    if (index < 64)
+        return (bits >> index) & 1;
+    
+    index -= 64;
+    return index / 64 < overflow.size() &&
+    ((overflow[index / 64] >> (index % 64)) & 1);
+}
+
+bool child_bitset::empty() const
+{
+    // overflow grows only when setting bit in it, so its last word is never 0
+    return bits == 0 && overflow.empty();
+}
+
+void child_bitset::clear()
+{
+    bits = 0;
+    overflow.clear();
+}
+
+size_t child_bitset::max() const
+{
+    assert(!empty());
+    
+    auto highest_bit =
+    [](uint64_t word)
+    {
+        size_t i = 63;
+        while (((word >> i) & 1) == 0)
+            --i;
+        return i;
+    };
+    
+    if (!overflow.empty())
+        return 64 + 64 * (overflow.size() - 1) + highest_bit(overflow.back());
+    return highest_bit(bits);
 }
 
 
@@ -38,7 +136,24 @@ bool rna_label::operator==(
 rna_pair_label::rna_pair_label(
                                const std::string& s)
 {
-    labels.push_back({s, point::bad_point()});
+    rna_label label;
+    label.set_label(s);
+    label.p = point::bad_point();
+    push_back(label);
+}
+
+rna_pair_label::rna_pair_label(
+                               char base)
+{
+    push_back({point::bad_point(), base});
+}
+
+void rna_pair_label::push_back(
+                               const rna_label& label)
+{
+    assert(labels_size < 2);
+    
+    labels[labels_size++] = label;
 }
 
 const rna_label& rna_pair_label::operator[](
@@ -46,15 +161,13 @@ const rna_label& rna_pair_label::operator[](
 {
     assert(index == 0 || index == 1);
     
-    try
-    {
-        return labels.at(index);
-    }
-    catch (const out_of_range& e)
+    if (index >= labels_size)
     {
         ERR("Trying to get label at illegal index %s; labels=%s", index, *this);
-        throw;
+        throw out_of_range("rna_pair_label::operator[]");
     }
+    
+    return labels[index];
 }
 
 rna_label& rna_pair_label::operator[](
@@ -62,15 +175,13 @@ rna_label& rna_pair_label::operator[](
 {
     assert(index == 0 || index == 1);
     
-    try
-    {
-        return labels.at(index);
-    }
-    catch (const out_of_range& e)
+    if (index >= labels_size)
     {
         ERR("Trying to get label at illegal index %s; labels=%s", index, *this);
-        throw;
+        throw out_of_range("rna_pair_label::operator[]");
     }
+    
+    return labels[index];
 }
 
 const rna_label& rna_pair_label::at(
@@ -88,10 +199,10 @@ rna_label& rna_pair_label::at(
 bool rna_pair_label::operator==(
                                 const rna_pair_label& other) const
 {
-    if (labels.size() != other.labels.size())
+    if (labels_size != other.labels_size)
         return false;
     
-    for (size_t i = 0; i < labels.size(); ++i)
+    for (size_t i = 0; i < labels_size; ++i)
         if (labels[i] != other.labels[i])
             return false;
     
@@ -104,8 +215,8 @@ rna_pair_label rna_pair_label::operator+(
     assert(!paired() && !other.paired());
     
     rna_pair_label out;
-    out.labels.push_back(labels.back());
-    out.labels.push_back(other.labels.back());
+    out.push_back(labels[labels_size - 1]);
+    out.push_back(other.labels[other.labels_size - 1]);
     
     return out;
 }
@@ -142,8 +253,8 @@ break;
     
     out << status;
     
-    for (const auto& val : lbl.labels)
-        out << val.label;
+    for (size_t i = 0; i < lbl.labels_size; ++i)
+        out << lbl.labels[i].label();
     
     if (!status.empty())
         out << "`";
@@ -181,15 +292,15 @@ size_t rna_pair_label::size() const
 
 bool rna_pair_label::paired() const
 {
-    assert(labels.size() == 1 || labels.size() == 2);
+    assert(labels_size == 1 || labels_size == 2);
     
-    return labels.size() == 2;
+    return labels_size == 2;
 }
 
 bool rna_pair_label::initiated_points() const
 {
-    for (const auto& lbl : labels)
-        if (lbl.p.bad())
+    for (size_t i = 0; i < labels_size; ++i)
+        if (labels[i].p.bad())
             return false;
     return true;
 }
@@ -209,8 +320,8 @@ point rna_pair_label::center() const
 
 void rna_pair_label::clear_points()
 {
-    for (auto& val : labels)
-        val.p = point::bad_point();
+    for (size_t i = 0; i < labels_size; ++i)
+        labels[i].p = point::bad_point();
 }
 
 void rna_pair_label::set_label_strings(
@@ -241,7 +352,7 @@ void rna_pair_label::set_label_strings(
     
     size_t n = paired() ? 2 : 1;
     for (size_t i = 0; i < n; ++i)
-        (*this)[i].label = other[i].label;
+        (*this)[i].base = other[i].base;
 }
 
 void rna_pair_label::set_parent_center(
@@ -25,9 +25,6 @@
 
 using namespace std;
 
-#define set_remake(iter) \
-rna_tree::parent(iter)->remake_ids.push_back(child_index(iter));
-
 //namapuje stromy na sebe
 matcher::matcher(
                  const rna_tree& templated,
@@ -49,7 +46,7 @@ rna_tree& matcher::run(
     mark(t1, map.get_to_remove(), rna_pair_label::deleted);
     mark(t2, map.get_to_insert(), rna_pair_label::inserted);
     
-    erase();
+    t1.erase_deleted();
     
     t1.set_postorder_ids();
     t2.set_postorder_ids();
@@ -70,6 +67,11 @@ rna_tree& matcher::run(
     return t1; //Resulting tree which will be used from now on (we are done with T2 at this point)
 }
 
+const std::vector<rna_tree::iterator>& matcher::get_edited() const
+{
+    return edited;
+}
+
 
 
 void matcher::mark(
@@ -94,40 +96,16 @@ void matcher::mark(
     rna.print_tree();
 }
 
-void matcher::erase()
-{
-    iterator it;
-    sibling_iterator ch;
-    
-    for (it = t1.begin(); it != t1.end(); ++it)
-    {
-        for (ch = it.begin(); ch != it.end();)
-        {
-            if (is(ch, rna_pair_label::deleted))
-            {
-                /*
-                 * Set Information for the drawing algorithm that descendants will need to be moved
-                 * and siblings (loop) will need to be replaced on the circle
-                 */
-                set_remake(ch);
-                ch = t1.erase(ch);
-                
-                continue;
-            }
-            ++ch;
-        }
-    }
-}
-
 //mapovani jednoho stromu na druhy
 void matcher::merge()
 {
     iterator it1, it2;
     sibling_iterator ch1, ch2, ins;
-    size_t actual, needed, steal;
+    size_t actual, needed, steal, index;
     
     it1 = t1.begin();
     it2 = t2.begin();
+    edited.clear();
     
     it1->set_label_strings(*it2);
     
@@ -135,6 +113,8 @@ void matcher::merge()
     {
         ch1 = it1.begin();
         ch2 = it2.begin();
+        // position of ch1 in children of it1, no need to count siblings
+        index = 0;
         
         while (ch2 != it2.end())
         {
@@ -164,7 +144,7 @@ void matcher::merge()
                 }
                 ch1 = t1.insert(ins, *ch2, steal);
                 ch1->clear_points();
-                set_remake(ch1);
+                it1->remake_ids.insert(index);
             }
             else
             {
@@ -173,11 +153,15 @@ void matcher::merge()
             
             ++ch2;
             ++ch1;
+            ++index;
         }
         
         assert(ch1 == it1.end() && ch2 == it2.end());
         
-        make_unique(it1);
+        // it1 walks t1 in preorder including inserted nodes,
+        // so edited nodes are collected in preorder too
+        if (is(it1, rna_pair_label::inserted) || !it1->remake_ids.empty())
+            edited.push_back(it1);
         
         ++it1;
         ++it2;
@@ -224,13 +208,3 @@ void matcher::compute_sizes()
     assert(s1.at(id(t1.begin())) == s2.at(id(t2.begin())));
     
 }
-
-/* inline */
-void matcher::make_unique(
-                          iterator it)
-{
-    auto& vec = it->remake_ids;
-    sort(vec.begin(), vec.end());
-    auto end = unique(vec.begin(), vec.end());
-    vec.erase(end, vec.end());
-}
@@ -209,7 +209,7 @@ std::string document_writer::get_rna_background_formatted(
 }
 
 std::string document_writer::get_rna_formatted(
-                                               rna_tree rna) const
+                                               rna_tree& rna) const
 {
     return get_rna_subtree_formatted(rna.begin())
     + get_rna_background_formatted(rna.begin_pre_post(), rna.end_pre_post());
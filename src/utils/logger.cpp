@@ -30,6 +30,8 @@
 
 using namespace std;
 
+/* static */ thread_local int logger::thread_p = logger::NO_THREAD_PRIORITY;
+
 #ifndef NO_LOGGING
 
 #ifndef LOG_FILE
@@ -85,6 +87,8 @@ void logger::log(
     if (!can_log(p))
         return;
     
+    lock_guard<mutex> lock(out_mutex);
+    
     for (FILE* f : out)
     {
         fprintf(f, "%s", text.c_str());
@@ -102,7 +106,8 @@ void logger::log(
     
     clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cputime);
     clock_gettime(CLOCK_REALTIME, &clocks);
-    tm c = *localtime(&clocks.tv_sec);
+    tm c;
+    localtime_r(&clocks.tv_sec, &c);
     
     hour = c.tm_hour;
     minute = c.tm_min;
@@ -173,8 +178,7 @@ void logger::logger_stream::flush()
 {
     if (!l.can_log(p))
         return;
-    l.log(p, message_header(p));
-    l.log(p, stream.str());
+    l.log(p, message_header(p) + stream.str());
     stream.str("");
 }
 
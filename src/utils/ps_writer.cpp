@@ -156,7 +156,7 @@ std::string ps_writer::get_default_prologue() const
     
     out
     << get_color_formatted(color)
-    << get_text_formatted(label.p, label.label);
+    << get_text_formatted(label.p, label.label());
     
     return out.str();
 }
@@ -0,0 +1,177 @@
+/*
+ * File: shard.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include <sstream>
+
+#include "shard.hpp"
+#include "utils.hpp"
+
+#define SEPARATOR   '\t'
+
+using namespace std;
+
+static vector<string> split(
+                            const string& line);
+
+static string join(
+                   const vector<string>& values);
+
+/* static */ shard shard::parse(
+                                const std::string& text)
+{
+    shard s;
+    size_t slash = text.find('/');
+    
+    try
+    {
+        if (slash == string::npos)
+            throw invalid_argument(text);
+        
+        s.index = stoul(text.substr(0, slash));
+        s.count = stoul(text.substr(slash + 1));
+    }
+    catch (const logic_error&)
+    {
+        throw wrong_argument_exception("Shard '%s' has to be in format i/N", text);
+    }
+    
+    if (s.count == 0 || s.index >= s.count)
+        throw wrong_argument_exception("Shard '%s' has to satisfy 0 <= i < N", text);
+    
+    return s;
+}
+
+std::string shard::get_filename(
+                                const std::string& filename) const
+{
+    return msprintf("%s.shard-%s-of-%s", filename, index, count);
+}
+
+void shard_output::save(
+                        const std::string& filename) const
+{
+    APP_DEBUG_FNAME;
+    
+    ostringstream out;
+    
+    out
+    << join({type, to_string(part.index), to_string(part.count)}) << endl
+    << join(names) << endl;
+    for (const auto& record : records)
+        out << join(record) << endl;
+    
+    write_file_atomic(filename,
+                      [&out](const string& file) {
+                          write_file(file, out.str());
+                      });
+}
+
+/* static */ shard_output shard_output::load(
+                                             const std::string& filename)
+{
+    APP_DEBUG_FNAME;
+    
+    istringstream in(read_file(filename));
+    shard_output output;
+    vector<string> header;
+    string line;
+    
+    getline(in, line);
+    header = split(line);
+    if (header.size() != 3)
+        throw io_exception("Shard output %s has wrong header", filename);
+    
+    output.type = header[0];
+    output.part = shard::parse(header[1] + "/" + header[2]);
+    
+    getline(in, line);
+    output.names = split(line);
+    
+    while (getline(in, line))
+        output.records.push_back(split(line));
+    
+    return output;
+}
+
+/* static */ size_t shard_output::parse_number(
+                                               const std::string& text)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != string::npos)
+        throw invalid_argument(text);
+    
+    return stoul(text);
+}
+
+/* static */ std::vector<shard_output> shard_output::load_all(
+                                                              const std::string& filename,
+                                                              size_t count)
+{
+    APP_DEBUG_FNAME;
+    
+    vector<shard_output> outputs;
+    shard part;
+    
+    part.count = count;
+    for (part.index = 0; part.index < count; ++part.index)
+    {
+        string file = part.get_filename(filename);
+        shard_output output = load(file);
+        
+        if (output.part.index != part.index || output.part.count != count)
+            throw io_exception("Shard output %s belongs to other shard", file);
+        if (!outputs.empty() &&
+            (output.type != outputs[0].type || output.names != outputs[0].names))
+            throw io_exception("Shard output %s does not match other shards", file);
+        
+        outputs.push_back(output);
+    }
+    
+    return outputs;
+}
+
+/* local */ vector<string> split(
+                                 const string& line)
+{
+    vector<string> values;
+    istringstream in(line);
+    string value;
+    
+    while (getline(in, value, SEPARATOR))
+        values.push_back(value);
+    
+    return values;
+}
+
+/* local */ string join(
+                        const vector<string>& values)
+{
+    ostringstream out;
+    
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i != 0)
+            out << SEPARATOR;
+        out << values[i];
+    }
+    
+    return out.str();
+}
@@ -185,7 +185,7 @@ struct svg_writer::style
     << get_point_formatted(label.p, "", "")
     << property("class", color.get_name());
     
-    return create_element("text", out, label.label);
+    return create_element("text", out, label.label());
 }
 
 
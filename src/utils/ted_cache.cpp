@@ -0,0 +1,162 @@
+/*
+ * File: ted_cache.cpp
+ *
+ * Copyright (C) 2016 Richard Eliáš <richard.elias@matfyz.cz>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+ * USA.
+ */
+
+
+#include "ted_cache.hpp"
+#include "gted.hpp"
+#include "mapping.hpp"
+#include "utils.hpp"
+
+#define KEY_EXTENSION       ".key"
+#define STRATEGY_EXTENSION  ".str"
+#define MAPPING_EXTENSION   ".map"
+
+using namespace std;
+
+ted_cache::ted_cache(
+                     const std::string& _directory)
+: directory(_directory)
+{
+    APP_DEBUG_FNAME;
+    
+    create_directory(directory);
+}
+
+/* static */ std::string ted_cache::get_key(
+                                            const rna_tree& templated,
+                                            const rna_tree& matched,
+                                            const std::string& engine)
+{
+    return msprintf("engine=%s\ncosts=%s\ntemplate=%s\ntarget=%s\n",
+                    engine, gted::costs::description(),
+                    templated.get_brackets(), matched.get_brackets());
+}
+
+bool ted_cache::load_mapping(
+                             const std::string& key,
+                             mapping& map) const
+{
+    APP_DEBUG_FNAME;
+    
+    string file = get_filename(key, MAPPING_EXTENSION);
+    
+    if (!contains_key(key) || !exist_file(file))
+        return false;
+    
+    map = load_mapping_table(file);
+    INFO("TED cache: loaded mapping %s", file);
+    
+    return true;
+}
+
+bool ted_cache::load_strategies(
+                                const std::string& key,
+                                strategy_table_type& strategies) const
+{
+    APP_DEBUG_FNAME;
+    
+    string file = get_filename(key, STRATEGY_EXTENSION);
+    
+    if (!contains_key(key) || !exist_file(file))
+        return false;
+    
+    strategies = load_strategy_table(file);
+    INFO("TED cache: loaded strategies %s", file);
+    
+    return true;
+}
+
+void ted_cache::save_mapping(
+                             const std::string& key,
+                             const mapping& map) const
+{
+    APP_DEBUG_FNAME;
+    
+    if (!save_key(key))
+        return;
+    
+    write_file_atomic(get_filename(key, MAPPING_EXTENSION),
+                      [&map](const string& file) {
+                          save_tree_mapping_table(file, map);
+                      });
+}
+
+void ted_cache::save_strategies(
+                                const std::string& key,
+                                const strategy_table_type& strategies) const
+{
+    APP_DEBUG_FNAME;
+    
+    if (!save_key(key))
+        return;
+    
+    write_file_atomic(get_filename(key, STRATEGY_EXTENSION),
+                      [&strategies](const string& file) {
+                          save_strategy_table(file, strategies);
+                      });
+}
+
+bool ted_cache::contains_key(
+                             const std::string& key) const
+{
+    string file = get_filename(key, KEY_EXTENSION);
+    
+    if (!exist_file(file))
+        return false;
+    
+    if (read_file(file) != key)
+    {
+        WARN("TED cache: hash collision in %s, ignoring cached entry", file);
+        return false;
+    }
+    return true;
+}
+
+bool ted_cache::save_key(
+                         const std::string& key) const
+{
+    string file = get_filename(key, KEY_EXTENSION);
+    
+    if (exist_file(file))
+    {
+        if (read_file(file) == key)
+            return true;
+        
+        // entry belongs to another key, overwriting its data would corrupt it
+        WARN("TED cache: hash collision in %s, result is not cached", file);
+        return false;
+    }
+    
+    write_file_atomic(file,
+                      [&key](const string& tmp) {
+                          write_file(tmp, key);
+                      });
+    
+    // other process could write colliding key at the same time
+    return read_file(file) == key;
+}
+
+std::string ted_cache::get_filename(
+                                    const std::string& key,
+                                    const std::string& extension) const
+{
+    return directory + "/" + hash_string(key) + extension;
+}
@@ -31,7 +31,7 @@ string traveler_writer::get_label_formatted(const rna_label& label, const RGB& c
 {
     ostringstream out;
     
-    out << "<point x=\"" << label.p.x << "\" y=\"" << label.p.y << "\" b=\"" << label.label << "\"/>"
+    out << "<point x=\"" << label.p.x << "\" y=\"" << label.p.y << "\" b=\"" << label.label() << "\"/>"
     << endl;
     
     return out.str();
@@ -44,13 +44,12 @@ using namespace std;
 logger_end_of_function_priority::logger_end_of_function_priority(
                                                                  logger::priority new_priority)
 {
-    old_priority = logger.get_priority();
-    logger.set_priority(new_priority);
+    old_priority = logger.set_thread_priority(new_priority);
 }
 
 logger_end_of_function_priority::~logger_end_of_function_priority()
 {
-    logger.set_priority(old_priority);
+    logger.set_thread_priority(old_priority);
 }
 
 print_class_BEG_END_name::print_class_BEG_END_name(
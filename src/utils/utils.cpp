@@ -21,24 +21,24 @@
 
 
 #include <fstream>
+#include <iomanip>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 #include "utils.hpp"
 #include "mapping.hpp"
+#include "dot_bracket.hpp"
 #include "exception.hpp"
 
-using namespace std;
-
-template<typename container_type, typename value_container_type>
-bool contains_one_of(
-                     const container_type& container,
-                     const value_container_type& values)
-{
-    for (const auto& val : values)
-        if (contains(container, val))
-            return true;
-    return false;
-}
+#define FNV_OFFSET_BASIS    14695981039346656037ULL
+#define FNV_PRIME           1099511628211ULL
 
+using namespace std;
 
 /* global */ std::string read_file(
                                    const std::string& filename)
@@ -70,6 +70,94 @@ bool contains_one_of(
         throw io_exception("write_file(%s) failed", filename);
 }
 
+/* global */ void write_file_atomic(
+                                    const std::string& filename,
+                                    const std::function<void(const std::string&)>& write_function)
+{
+    static atomic<size_t> counter(0);
+    
+    string tmp = msprintf("%s.tmp.%s.%s", filename, getpid(), counter++);
+    
+    try
+    {
+        write_function(tmp);
+    }
+    catch (...)
+    {
+        remove(tmp.c_str());
+        throw;
+    }
+    
+    if (rename(tmp.c_str(), filename.c_str()) != 0)
+    {
+        int err = errno;
+        remove(tmp.c_str());
+        throw io_exception("write_file_atomic(%s) failed: %s", filename, strerror(err));
+    }
+}
+
+/* global */ void create_directory(
+                                   const std::string& dirname)
+{
+    struct stat st;
+    
+    if (stat(dirname.c_str(), &st) == 0)
+    {
+        if (!S_ISDIR(st.st_mode))
+            throw io_exception("create_directory(%s) failed, file is not directory", dirname);
+        return;
+    }
+    
+    if (mkdir(dirname.c_str(), 0755) != 0 && errno != EEXIST)
+        throw io_exception("create_directory(%s) failed: %s", dirname, strerror(errno));
+}
+
+/* global */ std::vector<std::string> list_directory(
+                                                     const std::string& dirname)
+{
+    vector<string> files;
+    DIR* dir = opendir(dirname.c_str());
+    struct dirent* entry;
+    
+    if (dir == nullptr)
+        throw io_exception("list_directory(%s) failed: %s", dirname, strerror(errno));
+    
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        struct stat st;
+        string name = entry->d_name;
+        
+        if (stat((dirname + "/" + name).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            files.push_back(name);
+    }
+    closedir(dir);
+    
+    sort(files.begin(), files.end());
+    
+    return files;
+}
+
+/* global */ std::string hash_string(
+                                     const std::string& str)
+{
+    unsigned long long h = FNV_OFFSET_BASIS;
+    
+    for (unsigned char ch : str)
+    {
+        h ^= ch;
+        h *= FNV_PRIME;
+    }
+    
+    ostringstream out;
+    out
+    << hex
+    << setfill('0')
+    << setw(16)
+    << h;
+    
+    return out.str();
+}
+
 /* global */ fasta read_fasta_file(
                                    const std::string& filename)
 {
@@ -77,7 +165,7 @@ bool contains_one_of(
         throw io_exception("read_file(%s) failed, file does not exist", filename);
     
     ifstream in(filename);
-    ostringstream labels, brackets;
+    string labels, brackets;
     string id, line;
     
     while(true)
@@ -103,24 +191,26 @@ bool contains_one_of(
         if (contains(line, '>'))
             break;
         
-      if ( line.size() && line[line.size()-1] == '\r' ) {
-           DEBUG("Removing carriage return\n");
-           line = line.substr( 0, line.size() - 1 );
+        if (!line.empty() && line.back() == '\r')
+        {
+            DEBUG("Removing carriage return\n");
+            line.pop_back();
         }
-
-        if ( line.size() && line[line.size()-1] == '\n' ) {
-           DEBUG("Removing line feed\n");
-           line = line.substr( 0, line.size() - 1 );
+        if (!line.empty() && line.back() == '\n')
+        {
+            DEBUG("Removing line feed\n");
+            line.pop_back();
         }
-        if (contains_one_of(line, "[{(.)}]"))
-            brackets << line;
+        
+        if (dot_bracket::is_structure_line(line))
+            brackets += line;
         else
-            labels << line;
+            labels += line;
     }
     fasta f;
     f.id = id;
-    f.brackets = brackets.str();
-    f.labels = labels.str();
+    f.brackets = move(brackets);
+    f.labels = move(labels);
     
     DEBUG("%s", to_cstr(f));
     return f;